@@ -0,0 +1,9 @@
+#!/bin/bash
+
+set -e
+
+g++ -std=c++17 -O2 -pthread bench/bench.cpp -o list_bench
+g++ -std=c++17 -O2 -pthread bench/queue_bench.cpp -o queue_bench
+
+./list_bench
+./queue_bench
@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/list.h"
+
+// Compares task::list (with std::allocator and with the node pool) against
+// std::list, std::deque and std::vector for the common list operations and
+// element sizes from 4 to 256 bytes. Every line reports the time per
+// element operation and the number of heap allocations per operation, as
+// counted by the replaced global operator new.
+//
+// Usage: list_bench [elements]
+
+
+static std::atomic<size_t> allocations(0);
+static volatile uint64_t sink;
+
+// All forms of operator new and delete are replaced together, so every
+// allocation and release goes through the same malloc/free pair. They are
+// kept out of line so that GCC pairs the library's new and delete calls by
+// name instead of seeing malloc freed by a sized delete.
+void* CountedAlloc(size_t size) noexcept {
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+
+// Over-aligned forms: aligned_alloc wants a size that is a multiple of the
+// alignment, and its blocks are released with free as well.
+void* CountedAlloc(size_t size, std::align_val_t align) noexcept {
+    ++allocations;
+    auto alignment = static_cast<size_t>(align);
+    return std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment);
+}
+
+[[gnu::noinline]] void* operator new(size_t size) {
+    if (void* ptr = CountedAlloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new[](size_t size) {
+    if (void* ptr = CountedAlloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size);
+}
+
+[[gnu::noinline]] void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size);
+}
+
+[[gnu::noinline]] void* operator new(size_t size, std::align_val_t align) {
+    if (void* ptr = CountedAlloc(size, align)) return ptr;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new[](size_t size, std::align_val_t align) {
+    if (void* ptr = CountedAlloc(size, align)) return ptr;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, align);
+}
+
+[[gnu::noinline]] void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, align);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+
+template <size_t Size>
+struct Blob {
+    explicit Blob(uint32_t key = 0): key(key) {
+
+    }
+
+    bool operator<(const Blob& other) const {
+        return key < other.key;
+    }
+
+    bool operator==(const Blob& other) const {
+        return key == other.key;
+    }
+
+    uint32_t key;
+    char payload[Size - sizeof(uint32_t)] = {};
+};
+
+uint32_t KeyOf(int value) {
+    return value;
+}
+
+template <size_t Size>
+uint32_t KeyOf(const Blob<Size>& value) {
+    return value.key;
+}
+
+
+template <class Container>
+struct Traits {
+    static constexpr bool kList = false;
+    static constexpr bool kFront = true;
+};
+
+template <class T>
+struct Traits<std::vector<T>> {
+    static constexpr bool kList = false;
+    static constexpr bool kFront = false;
+};
+
+template <class T>
+struct Traits<std::list<T>> {
+    static constexpr bool kList = true;
+    static constexpr bool kFront = true;
+};
+
+template <class T, class Alloc>
+struct Traits<task::list<T, Alloc>> {
+    static constexpr bool kList = true;
+    static constexpr bool kFront = true;
+};
+
+
+class Timer {
+public:
+    Timer(const std::string& container, size_t elem_size):
+        container_(container), elem_size_(elem_size) {
+
+    }
+
+    // Runs `body`, which performs `ops` element operations, and prints a line.
+    template <class Body>
+    void Measure(const std::string& op, size_t ops, Body body) {
+        auto allocs = allocations.load();
+        auto begin = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        allocs = allocations.load() - allocs;
+
+        auto ns = std::chrono::duration<double, std::nano>(end - begin).count();
+        std::cout << std::left << std::setw(16) << op << std::setw(24) << container_
+                  << std::right << std::setw(6) << elem_size_
+                  << std::fixed << std::setprecision(2) << std::setw(12) << ns / ops
+                  << std::setw(12) << static_cast<double>(allocs) / ops << '\n';
+    }
+
+private:
+    std::string container_;
+    size_t elem_size_;
+};
+
+
+template <class Container>
+void Fill(Container& container, const std::vector<uint32_t>& keys) {
+    for (auto key: keys) {
+        container.emplace_back(key);
+    }
+}
+
+template <class T, class Container>
+void Run(const std::string& name, size_t count) {
+    Timer timer(name, sizeof(T));
+
+    std::mt19937 rand(42);
+    std::vector<uint32_t> keys(count);
+    for (auto& key: keys) {
+        key = rand() % (count / 4 + 1);
+    }
+
+    timer.Measure("push/pop back", 2 * count, [&] {
+        Container container;
+        for (size_t i = 0; i < count; ++i) container.emplace_back(i);
+        for (size_t i = 0; i < count; ++i) container.pop_back();
+    });
+
+    if constexpr (Traits<Container>::kFront) {
+        timer.Measure("push/pop front", 2 * count, [&] {
+            Container container;
+            for (size_t i = 0; i < count; ++i) container.emplace_front(i);
+            for (size_t i = 0; i < count; ++i) container.pop_front();
+        });
+    }
+
+    // Inserts and erases around the middle of a container of `middle` elements.
+    size_t middle = std::min<size_t>(count, 20000);
+    timer.Measure("middle ins/er", 2 * middle, [&] {
+        Container container;
+        Fill(container, std::vector<uint32_t>(keys.begin(), keys.begin() + middle));
+        if constexpr (Traits<Container>::kList) {
+            auto pos = std::next(container.begin(), middle / 2);
+            for (size_t i = 0; i < middle; ++i) container.emplace(pos, i);
+            for (size_t i = 0; i < middle; ++i) pos = container.erase(std::prev(pos));
+        } else {
+            for (size_t i = 0; i < middle; ++i) container.emplace(container.begin() + container.size() / 2, i);
+            for (size_t i = 0; i < middle; ++i) container.erase(container.begin() + container.size() / 2);
+        }
+    });
+
+    Container container;
+    Fill(container, keys);
+
+    timer.Measure("iterate", count, [&] {
+        uint64_t sum = 0;
+        for (const auto& value: container) sum += KeyOf(value);
+        sink = sum;
+    });
+
+    timer.Measure("reverse", count, [&] {
+        if constexpr (Traits<Container>::kList) {
+            container.reverse();
+        } else {
+            std::reverse(container.begin(), container.end());
+        }
+    });
+
+    timer.Measure("sort", count, [&] {
+        if constexpr (Traits<Container>::kList) {
+            container.sort();
+        } else {
+            std::sort(container.begin(), container.end());
+        }
+    });
+
+    timer.Measure("unique", count, [&] {
+        if constexpr (Traits<Container>::kList) {
+            container.unique();
+        } else {
+            container.erase(std::unique(container.begin(), container.end()), container.end());
+        }
+    });
+
+    // Lists exchanging nodes must share an allocator, i.e. one node pool.
+    Container other(container.get_allocator());
+    Fill(other, keys);
+    if constexpr (Traits<Container>::kList) {
+        other.sort();
+    } else {
+        std::sort(other.begin(), other.end());
+    }
+    auto merged = container.size() + other.size();
+
+    timer.Measure("merge", merged, [&] {
+        if constexpr (Traits<Container>::kList) {
+            container.merge(other);
+        } else {
+            auto half = container.size();
+            container.insert(container.end(), other.begin(), other.end());
+            std::inplace_merge(container.begin(), container.begin() + half, container.end());
+        }
+    });
+
+    if constexpr (Traits<Container>::kList) {
+        // Moves blocks of 100 elements from the front of one list to the
+        // back of another.
+        Container target(container.get_allocator());
+        size_t moves = container.size() / 100;
+        timer.Measure("splice 100", moves, [&] {
+            for (size_t i = 0; i < moves; ++i) {
+                auto last = std::next(container.begin(), 100);
+                target.splice(target.end(), container, container.begin(), last);
+            }
+        });
+    }
+}
+
+
+template <class T>
+void RunAll(size_t count) {
+    Run<T, task::list<T>>("task::list", count);
+    Run<T, task::list<T, task::PoolAllocator<T>>>("task::list + pool", count);
+    Run<T, std::list<T>>("std::list", count);
+    Run<T, std::deque<T>>("std::deque", count);
+    Run<T, std::vector<T>>("std::vector", count);
+}
+
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    std::cout << std::left << std::setw(16) << "operation" << std::setw(24) << "container"
+              << std::right << std::setw(6) << "bytes" << std::setw(12) << "ns/op"
+              << std::setw(12) << "allocs/op" << '\n';
+
+    RunAll<int>(count);
+    RunAll<Blob<64>>(count);
+    RunAll<Blob<256>>(count);
+}
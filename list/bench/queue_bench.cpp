@@ -0,0 +1,89 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/list.h"
+#include "../src/concurrent_queue.h"
+
+// Producer/consumer throughput of concurrent_queue against task::list behind
+// one mutex. Usage: queue_bench [threads] [items per producer]
+
+
+class LockedList {
+public:
+    void push_back(size_t value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        list_.push_back(value);
+    }
+
+    bool pop_front(size_t& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (list_.empty()) return false;
+        value = list_.front();
+        list_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    task::list<size_t> list_;
+};
+
+
+template <class Queue>
+double RunNsPerOp(size_t producers, size_t consumers, size_t items) {
+    Queue queue;
+    std::atomic<size_t> popped(0);
+    std::atomic<bool> start(false);
+    auto total = producers * items;
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            while (not start) {}
+            for (size_t i = 0; i < items; ++i) {
+                queue.push_back(i);
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            while (not start) {}
+            size_t value;
+            while (popped < total) {
+                if (queue.pop_front(value)) {
+                    ++popped;
+                }
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start = true;
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Every item is pushed once and popped once.
+    return std::chrono::duration<double, std::nano>(end - begin).count() / (2 * total);
+}
+
+
+int main(int argc, char** argv) {
+    size_t threads = argc > 1 ? std::stoul(argv[1]) : 8;
+    size_t items = argc > 2 ? std::stoul(argv[2]) : 200000;
+    auto producers = std::max<size_t>(1, threads / 2);
+    auto consumers = std::max<size_t>(1, threads - producers);
+
+    std::cout << producers << " producers, " << consumers << " consumers, "
+              << items << " items per producer\n";
+    std::cout << "mutex + task::list      " << RunNsPerOp<LockedList>(producers, consumers, items) << " ns/op\n";
+    std::cout << "task::concurrent_queue  "
+              << RunNsPerOp<task::concurrent_queue<size_t>>(producers, consumers, items) << " ns/op\n";
+}
@@ -0,0 +1,335 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace task {
+
+
+    // Lock-free multi-producer multi-consumer FIFO queue (Michael and Scott).
+    // Nodes follow the list node layout, a link plus the value, with the link
+    // made atomic; the queue always starts with a dummy node whose value slot
+    // is empty.
+    //
+    // The node is its own type rather than list's BaseNode/Node: those carry
+    // a plain prev/next pair and construct the value with the node, while
+    // the queue needs a single atomic link, no back link, and raw storage
+    // for the value that the dummy node leaves unconstructed.
+    //
+    // Popped nodes are reclaimed with hazard pointers: a thread publishes the
+    // nodes it is about to dereference, and retired nodes are freed only once
+    // no published hazard refers to them. Every operation borrows a hazard
+    // record for its duration, so any number of threads may use the queue.
+    // A thread first tries the record it borrowed last, so threads do not
+    // all contend on the first record of the list.
+    // Nodes are allocated and freed from several threads at once, so the
+    // allocator has to be thread-safe (std::allocator is, a PoolAllocator
+    // is not).
+    template<class T, class Alloc = std::allocator<T>>
+    class concurrent_queue {
+        struct Node;
+        struct HazardRecord;
+
+    public:
+        concurrent_queue();
+        explicit concurrent_queue(const Alloc& alloc);
+        ~concurrent_queue();
+
+        concurrent_queue(const concurrent_queue&) = delete;
+        concurrent_queue& operator=(const concurrent_queue&) = delete;
+
+        void push_back(const T& value);
+        void push_back(T&& value);
+
+        template <class... Args>
+        void emplace_back(Args&&... args);
+
+        // Moves the first element into `value`; returns false if the queue
+        // was empty.
+        bool pop_front(T& value);
+
+        // A snapshot that may be stale by the time it is returned.
+        bool empty() const;
+
+    private:
+        static constexpr size_t kHazards = 2;
+
+        struct Node {
+            Node(): next(nullptr) {
+
+            }
+
+            T* value() {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+
+            std::atomic<Node*> next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        struct HazardRecord {
+            std::atomic<bool> active{false};
+            std::atomic<Node*> hazards[kHazards] = {};
+            HazardRecord* next = nullptr;
+            std::vector<Node*> retired;
+        };
+
+        // Borrowed record of the calling thread, returned on scope exit.
+        class HazardGuard {
+        public:
+            explicit HazardGuard(concurrent_queue& queue): record_(queue.acquire_record()) {
+
+            }
+
+            ~HazardGuard() {
+                for (auto& hazard: record_->hazards) {
+                    hazard.store(nullptr);
+                }
+                record_->active.store(false);
+            }
+
+            // Reads `source` and publishes the pointer, retrying until the
+            // published value is still current.
+            Node* protect(size_t slot, const std::atomic<Node*>& source) {
+                auto node = source.load();
+                while (true) {
+                    record_->hazards[slot].store(node);
+                    auto current = source.load();
+                    if (current == node) return node;
+                    node = current;
+                }
+            }
+
+            void set(size_t slot, Node* node) {
+                record_->hazards[slot].store(node);
+            }
+
+            HazardRecord* record() const {
+                return record_;
+            }
+
+        private:
+            HazardRecord* record_;
+        };
+
+        // Record a thread borrowed last, tagged with the id of its queue:
+        // a later queue at the same address must not match.
+        struct CachedRecord {
+            uint64_t queue = 0;
+            HazardRecord* record = nullptr;
+        };
+
+        static CachedRecord& cached_record() {
+            static thread_local CachedRecord cached;
+            return cached;
+        }
+
+        static uint64_t next_id() {
+            static std::atomic<uint64_t> last(0);
+            return ++last;
+        }
+
+        HazardRecord* acquire_record();
+        void retire(HazardRecord* record, Node* node);
+        void scan(HazardRecord* record);
+        void push_node(Node* node);
+        void free_node(Node* node);
+
+        std::atomic<Node*> head_;
+        std::atomic<Node*> tail_;
+        std::atomic<HazardRecord*> records_;
+        std::atomic<size_t> record_count_;
+        const uint64_t id_;
+        typename std::allocator_traits<Alloc>::template rebind_alloc<Node> node_alloc_;
+    };
+
+    template<class T, class Alloc>
+    concurrent_queue<T, Alloc>::concurrent_queue(): concurrent_queue(Alloc()) {
+
+    }
+
+    template<class T, class Alloc>
+    concurrent_queue<T, Alloc>::concurrent_queue(const Alloc& alloc):
+        head_(nullptr), tail_(nullptr), records_(nullptr), record_count_(0), id_(next_id()), node_alloc_(alloc) {
+        auto dummy = node_alloc_.allocate(1);
+        ::new((void *)dummy) Node();
+        head_.store(dummy);
+        tail_.store(dummy);
+    }
+
+    template<class T, class Alloc>
+    concurrent_queue<T, Alloc>::~concurrent_queue() {
+        // No other thread may use the queue any more.
+        auto dummy = head_.load();
+        auto node = dummy->next.load();
+        free_node(dummy);
+        while (node != nullptr) {
+            auto next = node->next.load();
+            node->value()->~T();
+            free_node(node);
+            node = next;
+        }
+
+        for (auto record = records_.load(); record != nullptr; ) {
+            auto next = record->next;
+            for (auto retired: record->retired) {
+                free_node(retired);
+            }
+            delete record;
+            record = next;
+        }
+    }
+
+    template<class T, class Alloc>
+    void concurrent_queue<T, Alloc>::push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    template<class T, class Alloc>
+    void concurrent_queue<T, Alloc>::push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template<class T, class Alloc>
+    template <class... Args>
+    void concurrent_queue<T, Alloc>::emplace_back(Args&&... args) {
+        auto node = node_alloc_.allocate(1);
+        ::new((void *)node) Node();
+        try {
+            ::new((void *)node->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            free_node(node);
+            throw;
+        }
+        push_node(node);
+    }
+
+    template<class T, class Alloc>
+    void concurrent_queue<T, Alloc>::push_node(Node* node) {
+        HazardGuard guard(*this);
+        while (true) {
+            auto tail = guard.protect(0, tail_);
+            auto next = tail->next.load();
+            if (tail != tail_.load()) continue;
+
+            if (next != nullptr) {
+                // Another push linked its node but has not swung the tail yet.
+                tail_.compare_exchange_weak(tail, next);
+                continue;
+            }
+
+            Node* expected = nullptr;
+            if (tail->next.compare_exchange_weak(expected, node)) {
+                tail_.compare_exchange_strong(tail, node);
+                return;
+            }
+        }
+    }
+
+    template<class T, class Alloc>
+    bool concurrent_queue<T, Alloc>::pop_front(T& value) {
+        HazardGuard guard(*this);
+        while (true) {
+            auto head = guard.protect(0, head_);
+            auto tail = tail_.load();
+            auto next = head->next.load();
+            guard.set(1, next);
+            if (head != head_.load()) continue;
+
+            if (next == nullptr) return false;
+
+            if (head == tail) {
+                tail_.compare_exchange_weak(tail, next);
+                continue;
+            }
+
+            if (head_.compare_exchange_weak(head, next)) {
+                // `next` is the new dummy; only the winner of the exchange
+                // touches its value, and the hazard keeps it alive meanwhile.
+                auto item = next->value();
+                value = std::move(*item);
+                item->~T();
+                retire(guard.record(), head);
+                return true;
+            }
+        }
+    }
+
+    template<class T, class Alloc>
+    bool concurrent_queue<T, Alloc>::empty() const {
+        // Borrowing a record does not change the contents of the queue.
+        HazardGuard guard(const_cast<concurrent_queue&>(*this));
+        return guard.protect(0, head_)->next.load() == nullptr;
+    }
+
+    template<class T, class Alloc>
+    typename concurrent_queue<T, Alloc>::HazardRecord* concurrent_queue<T, Alloc>::acquire_record() {
+        auto try_take = [](HazardRecord* record) {
+            bool expected = false;
+            return not record->active.load() and record->active.compare_exchange_strong(expected, true);
+        };
+
+        auto& cached = cached_record();
+        if (cached.queue == id_ and try_take(cached.record)) {
+            return cached.record;
+        }
+
+        for (auto record = records_.load(); record != nullptr; record = record->next) {
+            if (try_take(record)) {
+                cached = {id_, record};
+                return record;
+            }
+        }
+
+        // Records are never unlinked, so a new one is pushed at the front.
+        auto record = new HazardRecord();
+        record->active.store(true);
+        auto head = records_.load();
+        do {
+            record->next = head;
+        } while (not records_.compare_exchange_weak(head, record));
+        ++record_count_;
+
+        cached = {id_, record};
+        return record;
+    }
+
+    template<class T, class Alloc>
+    void concurrent_queue<T, Alloc>::retire(HazardRecord* record, Node* node) {
+        record->retired.push_back(node);
+        if (record->retired.size() >= 2 * kHazards * record_count_.load() + 64) {
+            scan(record);
+        }
+    }
+
+    template<class T, class Alloc>
+    void concurrent_queue<T, Alloc>::scan(HazardRecord* record) {
+        std::vector<Node*> hazards;
+        for (auto other = records_.load(); other != nullptr; other = other->next) {
+            for (auto& hazard: other->hazards) {
+                if (auto node = hazard.load()) {
+                    hazards.push_back(node);
+                }
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        auto kept = std::partition(record->retired.begin(), record->retired.end(), [&](Node* node) {
+            return std::binary_search(hazards.begin(), hazards.end(), node);
+        });
+        for (auto it = kept; it != record->retired.end(); ++it) {
+            free_node(*it);
+        }
+        record->retired.erase(kept, record->retired.end());
+    }
+
+    template<class T, class Alloc>
+    void concurrent_queue<T, Alloc>::free_node(Node* node) {
+        node->~Node();
+        node_alloc_.deallocate(node, 1);
+    }
+
+}  // namespace task
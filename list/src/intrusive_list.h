@@ -0,0 +1,502 @@
+#pragma once
+#include <iterator>
+#include <utility>
+
+namespace task {
+
+
+    struct default_list_tag {};
+
+    // Links embedded in an element of an intrusive_list, like the BaseNode of
+    // task::list. An element derives from one hook per list it can be on,
+    // each with its own Tag:
+    //
+    //     struct Job: task::list_hook<ReadyTag>, task::list_hook<AllTag> {...};
+    //
+    // Copying an element does not copy its links: the copy starts unlinked.
+    template<class Tag = default_list_tag>
+    struct list_hook {
+        list_hook(): prev(nullptr), next(nullptr) {
+
+        }
+
+        list_hook(const list_hook&): list_hook() {
+
+        }
+
+        list_hook& operator=(const list_hook&) {
+            return *this;
+        }
+
+        bool is_linked() const {
+            return next != nullptr;
+        }
+
+        void connect(list_hook* other) {
+            next = other;
+            other->prev = this;
+        }
+
+        list_hook* prev;
+        list_hook* next;
+    };
+
+
+    // Doubly linked list threaded through the list_hook<Tag> of its elements.
+    // The list never allocates, copies or destroys elements: insertion, erase
+    // and splice only update links, and the caller keeps the elements alive
+    // while they are linked. An element is on at most one list per Tag.
+    template<class T, class Tag = default_list_tag>
+    class intrusive_list {
+        using hook = list_hook<Tag>;
+
+    public:
+
+        class const_iterator;
+        class iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            iterator(): node_(nullptr) {
+
+            }
+
+            iterator(hook* node): node_(node) {
+
+            }
+
+            operator const_iterator() const {
+                return {node_};
+            }
+
+            iterator& operator++() {
+                node_ = node_->next;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator res(*this);
+                node_ = node_->next;
+                return res;
+            }
+
+            reference operator*() const {
+                return static_cast<T&>(*node_);
+            }
+
+            pointer operator->() const {
+                return &static_cast<T&>(*node_);
+            }
+
+            iterator& operator--() {
+                node_ = node_->prev;
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator res(*this);
+                node_ = node_->prev;
+                return res;
+            }
+
+            bool operator==(iterator other) const  {
+                return node_ == other.node_;
+            }
+
+            bool operator!=(iterator other) const {
+                return node_ != other.node_;
+            }
+
+        private:
+            friend class intrusive_list;
+            hook* node_;
+        };
+
+        class const_iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using value_type = T;
+            using pointer = const T*;
+            using reference = const T&;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            const_iterator(): node_(nullptr) {
+
+            }
+
+            const_iterator(hook* node): node_(node) {
+
+            }
+
+            const_iterator& operator++() {
+                node_ = node_->next;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator res(*this);
+                node_ = node_->next;
+                return res;
+            }
+
+            reference operator*() const {
+                return static_cast<const T&>(*node_);
+            }
+
+            pointer operator->() const {
+                return &static_cast<const T&>(*node_);
+            }
+
+            const_iterator& operator--() {
+                node_ = node_->prev;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res(*this);
+                node_ = node_->prev;
+                return res;
+            }
+
+            bool operator==(const_iterator other) const  {
+                return node_ == other.node_;
+            }
+
+            bool operator!=(const_iterator other) const {
+                return node_ != other.node_;
+            }
+
+        private:
+            friend class intrusive_list;
+            hook* node_;
+        };
+
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+
+        intrusive_list();
+        ~intrusive_list();
+
+        intrusive_list(const intrusive_list&) = delete;
+        intrusive_list& operator=(const intrusive_list&) = delete;
+
+        intrusive_list(intrusive_list&& other);
+        intrusive_list& operator=(intrusive_list&& other);
+
+
+        T& front();
+        const T& front() const;
+
+        T& back();
+        const T& back() const;
+
+
+        iterator begin();
+        iterator end();
+
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+        reverse_iterator rbegin();
+        reverse_iterator rend();
+
+        const_reverse_iterator crbegin() const;
+        const_reverse_iterator crend() const;
+
+        // Iterator to an element known to be on this list, found in O(1).
+        iterator iterator_to(T& value);
+        const_iterator iterator_to(const T& value) const;
+
+
+        bool empty() const;
+        size_t size() const;
+        // Unlinks every element.
+        void clear();
+
+        iterator insert(const_iterator pos, T& value);
+
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator first, const_iterator last);
+        // Unlinks `value`, which must be on this list.
+        void erase(T& value);
+
+
+        void push_back(T& value);
+        void pop_back();
+
+        void push_front(T& value);
+        void pop_front();
+
+        void swap(intrusive_list& other);
+
+
+        void splice(const_iterator pos, intrusive_list& other);
+        void splice(const_iterator pos, intrusive_list& other, const_iterator it);
+        void splice(const_iterator pos, intrusive_list& other, const_iterator first, const_iterator last);
+        void reverse();
+
+    private:
+
+        void clear_ends(size_t new_size = 0);
+
+        void insert_nodes(const_iterator pos, size_t count, hook* first, hook* last);
+
+        static void unlink(hook* node);
+
+        size_t size_;
+        hook head_, tail_;
+    };
+
+    template<class T, class Tag>
+    intrusive_list<T, Tag>::intrusive_list(): size_(0), head_(), tail_() {
+        clear_ends();
+    }
+
+    template<class T, class Tag>
+    intrusive_list<T, Tag>::~intrusive_list() {
+        clear();
+    }
+
+    template<class T, class Tag>
+    intrusive_list<T, Tag>::intrusive_list(intrusive_list&& other): size_(0), head_(), tail_() {
+        clear_ends();
+        splice(cend(), other);
+    }
+
+    template<class T, class Tag>
+    intrusive_list<T, Tag>& intrusive_list<T, Tag>::operator=(intrusive_list&& other) {
+        if (this == &other) return *this;
+
+        clear();
+        splice(cend(), other);
+
+        return *this;
+    }
+
+    template<class T, class Tag>
+    T& intrusive_list<T, Tag>::front() {
+        return *begin();
+    }
+
+    template<class T, class Tag>
+    const T& intrusive_list<T, Tag>::front() const {
+        return *cbegin();
+    }
+
+    template<class T, class Tag>
+    T& intrusive_list<T, Tag>::back() {
+        return *(--end());
+    }
+
+    template<class T, class Tag>
+    const T& intrusive_list<T, Tag>::back() const {
+        return *(--cend());
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::iterator intrusive_list<T, Tag>::begin() {
+        return {head_.next};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::iterator intrusive_list<T, Tag>::end() {
+        return {&tail_};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::const_iterator intrusive_list<T, Tag>::cbegin() const {
+        return {head_.next};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::const_iterator intrusive_list<T, Tag>::cend() const {
+        return {const_cast<hook*>(&tail_)};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::reverse_iterator intrusive_list<T, Tag>::rbegin() {
+        return reverse_iterator(end());
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::reverse_iterator intrusive_list<T, Tag>::rend() {
+        return reverse_iterator(begin());
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::const_reverse_iterator intrusive_list<T, Tag>::crbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::const_reverse_iterator intrusive_list<T, Tag>::crend() const {
+        return const_reverse_iterator(cbegin());
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::iterator intrusive_list<T, Tag>::iterator_to(T& value) {
+        return {static_cast<hook*>(&value)};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::const_iterator intrusive_list<T, Tag>::iterator_to(const T& value) const {
+        return {const_cast<hook*>(static_cast<const hook*>(&value))};
+    }
+
+    template<class T, class Tag>
+    bool intrusive_list<T, Tag>::empty() const {
+        return size_ == 0;
+    }
+
+    template<class T, class Tag>
+    size_t intrusive_list<T, Tag>::size() const {
+        return size_;
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::clear() {
+        auto node = head_.next;
+        while (node != &tail_) {
+            auto next = node->next;
+            node->prev = node->next = nullptr;
+            node = next;
+        }
+
+        clear_ends();
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::iterator intrusive_list<T, Tag>::insert(const_iterator pos, T& value) {
+        auto node = static_cast<hook*>(&value);
+        insert_nodes(pos, 1, node, node);
+        return {node};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::iterator intrusive_list<T, Tag>::erase(const_iterator pos) {
+        auto next = pos.node_->next;
+        unlink(pos.node_);
+        --size_;
+
+        return {next};
+    }
+
+    template<class T, class Tag>
+    typename intrusive_list<T, Tag>::iterator intrusive_list<T, Tag>::erase(const_iterator first, const_iterator last) {
+        while (first != last) {
+            erase(first++);
+        }
+
+        return {last.node_};
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::erase(T& value) {
+        erase(iterator_to(value));
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::push_back(T& value) {
+        insert(cend(), value);
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::pop_back() {
+        erase(--cend());
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::push_front(T& value) {
+        insert(cbegin(), value);
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::pop_front() {
+        erase(cbegin());
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::swap(intrusive_list& other) {
+        if (this == &other) return;
+
+        intrusive_list temp;
+        temp.splice(temp.cend(), other);
+        other.splice(other.cend(), *this);
+        splice(cend(), temp);
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::splice(const_iterator pos, intrusive_list& other) {
+        if (other.empty()) return;
+        insert_nodes(pos, other.size_, other.head_.next, other.tail_.prev);
+        other.clear_ends();
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::splice(const_iterator pos, intrusive_list& other, const_iterator it) {
+        auto node = it.node_;
+        if (pos.node_ == node or pos.node_ == node->next) return;
+
+        node->prev->connect(node->next);
+        --other.size_;
+        insert_nodes(pos, 1, node, node);
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::splice(const_iterator pos, intrusive_list& other,
+                                        const_iterator first, const_iterator last) {
+        if (first == last) return;
+
+        size_t count = this == &other ? 0 : std::distance(first, last);
+        auto first_node = first.node_;
+        auto last_node = last.node_->prev;
+
+        first_node->prev->connect(last.node_);
+        other.size_ -= count;
+        insert_nodes(pos, count, first_node, last_node);
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::reverse() {
+        if (size_ < 2) return;
+
+        for (auto node = head_.next; node != &tail_; node = node->prev) {
+            std::swap(node->next, node->prev);
+        }
+
+        auto new_first = tail_.prev;
+        auto new_last = head_.next;
+        head_.connect(new_first);
+        new_last->connect(&tail_);
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::clear_ends(size_t new_size) {
+        tail_.prev = &head_;
+        head_.next = &tail_;
+        size_ = new_size;
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::insert_nodes(const_iterator pos, size_t count, hook* first, hook* last) {
+        auto tail_node = pos.node_;
+        auto head_node = tail_node->prev;
+
+        head_node->connect(first);
+        last->connect(tail_node);
+
+        size_ += count;
+    }
+
+    template<class T, class Tag>
+    void intrusive_list<T, Tag>::unlink(hook* node) {
+        node->prev->connect(node->next);
+        node->prev = node->next = nullptr;
+    }
+
+}  // namespace task
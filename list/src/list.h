@@ -1,19 +1,43 @@
 #pragma once
+#include <cassert>
 #include <iterator>
 #include <list>
 
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cmath>
 #include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <optional>
+#include <exception>
+#include <atomic>
+#include <mutex>
+
+#include "node_pool.h"
+#include "thread_pool.h"
 
 namespace task {
 
 
+    template<class InputIt>
+    using RequireInputIterator = std::enable_if_t<std::is_convertible<
+        typename std::iterator_traits<InputIt>::iterator_category, std::input_iterator_tag>::value>;
+
+
     template<class T, class Alloc = std::allocator<T>>
     class list {
         struct BaseNode;
         struct Node;
 
     public:
+        using value_type = T;
+        using allocator_type = Alloc;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
 
         class const_iterator;
         class iterator {
@@ -166,19 +190,36 @@ namespace task {
         using reverse_iterator = std::reverse_iterator<iterator>;
         using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+        // Owns one element taken out of a list by extract, together with the
+        // allocator of its node.
+        class node_type;
+
 
         list();
         explicit list(const Alloc& alloc);
         list(size_t count, const T& value, const Alloc& alloc = Alloc());
         explicit list(size_t count, const Alloc& alloc = Alloc());
+        template <class InputIt, class = RequireInputIterator<InputIt>>
+        list(InputIt first, InputIt last, const Alloc& alloc = Alloc());
 
         ~list();
 
         list(const list& other);
+        list(const list& other, const Alloc& alloc);
         list(list&& other);
+        list(list&& other, const Alloc& alloc);
+        // Allocators follow the propagate_on_container_* traits. Without
+        // propagation, a move between lists with unequal allocators moves
+        // the elements one by one into nodes of the target's allocator.
         list& operator=(const list& other);
         list& operator=(list&& other);
 
+        // Overwrite the values of the existing nodes first, then allocate or
+        // free only the difference in length.
+        void assign(size_t count, const T& value);
+        template <class InputIt, class = RequireInputIterator<InputIt>>
+        void assign(InputIt first, InputIt last);
+
         Alloc get_allocator() const;
 
 
@@ -210,10 +251,19 @@ namespace task {
         iterator insert(const_iterator pos, const T& value);
         iterator insert(const_iterator pos, T&& value);
         iterator insert(const_iterator pos, size_t count, const T& value);
+        template <class InputIt, class = RequireInputIterator<InputIt>>
+        iterator insert(const_iterator pos, InputIt first, InputIt last);
 
         iterator erase(const_iterator pos);
         iterator erase(const_iterator first, const_iterator last);
 
+        // Unlinks the element at `pos` without destroying it. Inserting the
+        // handle into a list whose allocator compares equal to its own (the
+        // same arena) relinks the node: nothing is copied or allocated. The
+        // allocators must compare equal; this is asserted.
+        node_type extract(const_iterator pos);
+        iterator insert(const_iterator pos, node_type&& node);
+
 
         void push_back(const T& value);
         void push_back(T&& value);
@@ -233,27 +283,180 @@ namespace task {
         void emplace_front(Args&&... args);
 
         void resize(size_t count);
+        // Swaps the allocators only if propagate_on_container_swap is set;
+        // otherwise they must compare equal.
         void swap(list& other);
 
 
+        // If the comparison throws, all elements of `other` are already in
+        // this list, in an unspecified order.
         void merge(list& other);
+        template <class Compare>
+        void merge(list& other, Compare comp);
         void splice(const_iterator pos, list& other);
-        void remove(const T& value);
+        void splice(const_iterator pos, list& other, const_iterator it);
+        void splice(const_iterator pos, list& other, const_iterator first, const_iterator last);
+        size_t remove(const T& value);
+        template <class UnaryPredicate>
+        size_t remove_if(UnaryPredicate pred);
         void reverse();
-        void unique();
+        size_t unique();
+        template <class BinaryPredicate>
+        size_t unique(BinaryPredicate pred);
+        // Optional positional index. While enabled, the list keeps the sizes
+        // of consecutive blocks of about sqrt(n) nodes, so nth and position
+        // take O(sqrt(n)) instead of a walk from an end. Insert, erase and
+        // splice of single elements or whole lists update it in O(sqrt(n));
+        // operations that reorder many nodes at once (sort, merge, reverse,
+        // range splice, remove_if, compact...) only mark it stale, and it is
+        // rebuilt in O(n) by the next query. Copies start without an index.
+        // As with any container, const members, nth and position included,
+        // may run concurrently with each other but not with a modification;
+        // the rebuild of a stale index by a const query is serialized by a
+        // mutex of the index.
+        void enable_index(bool enabled = true);
+        bool index_enabled() const;
+
+        iterator nth(size_t pos);
+        const_iterator nth(size_t pos) const;
+        size_t position(const_iterator it) const;
+
+        // Moves the elements into freshly allocated nodes laid out in list
+        // order; with a node pool they are contiguous runs of new slab memory.
+        // Other allocators get all the new nodes before any old one is freed,
+        // so for a moment the moved range takes twice its memory.
+        // Invalidates all iterators, pointers and references to elements.
+        void compact();
+        // Incremental form: relocates at most `max_nodes` nodes starting at
+        // `pos` and returns where the next step should continue, end() once
+        // the list is done. Invalidates iterators to the relocated elements.
+        iterator compact(const_iterator pos, size_t max_nodes);
+
+        // If the comparison throws, the list keeps all its elements in an
+        // unspecified order.
         void sort();
+        template <class Compare>
+        void sort(Compare comp);
+
+        // Stable sort that splits the list into runs, sorts them on the pool
+        // and merges them pairwise in parallel rounds. Nodes are relinked,
+        // elements are never copied or moved. A throwing comparison is
+        // handled as in sort.
+        template <class Compare = std::less<T>>
+        void parallel_sort(Compare comp = Compare(), thread_pool& pool = thread_pool::shared());
+
+        // Parallel traversals. One walk, or the positional index if enabled,
+        // cuts the list into a few chunks per thread, and the pool balances
+        // the chunks by work stealing. The callables run concurrently on
+        // different elements and must not throw.
+        template <class Function>
+        void parallel_for_each(Function f, thread_pool& pool = thread_pool::shared());
+        // Replaces every element with op(element).
+        template <class UnaryOperation>
+        void parallel_transform(UnaryOperation op, thread_pool& pool = thread_pool::shared());
+        // Folds the elements onto `init` in list order. `op` must be
+        // associative but need not be commutative; every chunk starts its
+        // fold from U(element).
+        template <class U, class BinaryOperation = std::plus<>>
+        U parallel_reduce(U init, BinaryOperation op = BinaryOperation(),
+                          thread_pool& pool = thread_pool::shared()) const;
 
     private:
 
         void clear_ends(size_t new_size= 0);
 
+        // Exchanges the elements and the index, but not the allocators.
+        void swap_nodes(list& other);
+
+        // Uninitialized nodes handed out by take_node. With a node pool, once its
+        // free list is empty, they come in contiguous runs of up to kNodeRun
+        // nodes, one allocation per run.
+        struct NodeRun {
+            Node* next = nullptr;
+            size_t left = 0;
+        };
+
+        Node* take_node(NodeRun& run, size_t remaining);
+
         template <class ... Args>
         std::pair<Node*, Node*> create_nodes(size_t count, Args&&... args);
 
+        template <class InputIt>
+        std::pair<Node*, Node*> copy_nodes(InputIt first, size_t count);
+
+        // Cleans up after an element constructor threw in create_nodes or
+        // copy_nodes: frees the nullptr-terminated chain of nodes built so
+        // far, the uninitialized node `failed` and the unused rest of `run`.
+        void discard_nodes(NodeRun& run, Node* first, Node* failed);
+
         void delete_node(BaseNode* base_node);
 
+        // Frees a chain of unlinked nodes joined through `next` and ending
+        // with nullptr; returns the number of nodes.
+        size_t delete_chain(BaseNode* first);
+
+        // Erases [pos, end()) as one chain.
+        void truncate(const_iterator pos);
+
         void insert_nodes(const_iterator pos, size_t count, BaseNode* first, BaseNode* last);
 
+        // Stable merge of the sorted chain `second` into the sorted chain
+        // `first`, both linked through `next` only and terminated by nullptr;
+        // ties go to `first`. If `comp` throws, `first` is left holding the
+        // nodes of both chains in no particular order.
+        template <class Compare>
+        static void merge_chains(BaseNode*& first, BaseNode* second, Compare& comp);
+
+        // Sorts a nullptr-terminated chain in place; if `comp` throws, `first`
+        // is left holding all its nodes in no particular order.
+        template <class Compare>
+        static void sort_chain(BaseNode*& first, Compare& comp);
+
+        // Appends the chain `second` to the chain `first`; returns the result.
+        static BaseNode* join_chains(BaseNode* first, BaseNode* second);
+
+        // Links a nullptr-terminated chain between head_ and tail_, restoring
+        // the prev pointers.
+        void relink_chain(BaseNode* first);
+
+        size_t chunk_count(const thread_pool& pool) const;
+        // Starts of `chunks` consecutive ranges of nearly equal length,
+        // followed by the end.
+        std::vector<BaseNode*> split_points(size_t chunks) const;
+        // Calls body(i, first, last) for every chunk [first, last) on the pool.
+        template <class Body>
+        void run_chunks(size_t chunks, thread_pool& pool, Body body) const;
+
+        static const T& value_of(const BaseNode* node) {
+            return static_cast<const Node*>(node)->value;
+        }
+
+        struct PositionIndex {
+            struct Block {
+                BaseNode* anchor;  // first node of the block
+                size_t count;
+            };
+
+            std::vector<Block> blocks;
+            std::unordered_map<const BaseNode*, size_t> block_of;  // anchor -> block
+            size_t block_size = 0;
+            std::atomic<bool> stale{true};
+            std::mutex rebuild_mutex;
+        };
+
+        // Rebuilds a stale index; const readers may call it concurrently.
+        void index_refresh() const;
+        void index_rebuild() const;
+        void index_renumber() const;
+        void index_invalidate();
+        // Block holding `node`, and the distance of `node` from its anchor.
+        size_t index_locate(const BaseNode* node, size_t& offset) const;
+        // Called once [first, ...) of `count` nodes is linked after `prev`.
+        void index_insert(BaseNode* prev, size_t count, BaseNode* first);
+        // Called while `node` is still linked.
+        void index_erase(BaseNode* node);
+        void index_split(size_t block);
+
         struct BaseNode {
             BaseNode(): prev(nullptr), next(nullptr) {};
 
@@ -277,9 +480,90 @@ namespace task {
             T value;
         };
 
+        using node_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+        using node_traits = std::allocator_traits<node_allocator>;
+
+        static constexpr bool kNodePool = IsNodePool<node_allocator>::value;
+        static constexpr size_t kNodeRun = 256;
+        static constexpr size_t kCompactRun = 4096;
+        static constexpr size_t kMinChunk = 64;
+        static constexpr size_t kChunksPerThread = 4;
+
         size_t size_;
         BaseNode head_, tail_;
-        typename Alloc::template rebind<Node>::other node_alloc_;
+        node_allocator node_alloc_;
+        std::unique_ptr<PositionIndex> index_;
+    };
+
+    template<class T, class Alloc>
+    class list<T, Alloc>::node_type {
+    public:
+        using value_type = T;
+        using allocator_type = Alloc;
+
+        node_type() = default;
+
+        node_type(node_type&& other): node_(other.node_), alloc_(std::move(other.alloc_)) {
+            other.node_ = nullptr;
+            other.alloc_.reset();
+        }
+
+        node_type& operator=(node_type&& other) {
+            if (this != &other) {
+                reset();
+                node_ = other.release();
+                alloc_ = std::move(other.alloc_);
+                other.reset();
+            }
+
+            return *this;
+        }
+
+        ~node_type() {
+            reset();
+        }
+
+        bool empty() const {
+            return node_ == nullptr;
+        }
+
+        explicit operator bool() const {
+            return node_ != nullptr;
+        }
+
+        T& value() const {
+            return node_->value;
+        }
+
+        Alloc get_allocator() const {
+            return Alloc(*alloc_);
+        }
+
+    private:
+        friend class list;
+
+        node_type(Node* node, const node_allocator& alloc): node_(node), alloc_(alloc) {
+
+        }
+
+        // Hands the node over to a list; the allocator stays behind.
+        Node* release() {
+            auto node = node_;
+            node_ = nullptr;
+            return node;
+        }
+
+        void reset() {
+            if (node_ != nullptr) {
+                node_traits::destroy(*alloc_, node_);
+                node_traits::deallocate(*alloc_, node_, 1);
+                node_ = nullptr;
+            }
+            alloc_.reset();
+        }
+
+        Node* node_ = nullptr;
+        std::optional<node_allocator> alloc_;
     };
 
     template<class T, class Alloc>
@@ -305,48 +589,55 @@ namespace task {
         insert_nodes(cend(), count, first, last);
     }
 
+    template<class T, class Alloc>
+    template <class InputIt, class>
+    list<T, Alloc>::list(InputIt first, InputIt last, const Alloc& alloc): list(alloc) {
+        insert(cend(), first, last);
+    }
+
     template<class T, class Alloc>
     list<T, Alloc>::~list() {
         clear();
     }
 
     template<class T, class Alloc>
-    list<T, Alloc>::list(const list& other): size_(0), head_(), tail_(), node_alloc_(other.node_alloc_) {
+    list<T, Alloc>::list(const list& other):
+        list(other, node_traits::select_on_container_copy_construction(other.node_alloc_)) {
 
-        clear_ends();
-
-        Node* prev_node = nullptr;
-        Node* first = nullptr;
-        for (auto node = other.head_.next; node != &other.tail_; node = node->next) {
-            Node* new_node = node_alloc_.allocate(1);
-            node_alloc_.construct(new_node, static_cast<Node*>(node)->value);
-            if (prev_node) {
-                prev_node->connect(new_node);
-            }
-            else {
-                first = new_node;
-            }
-            prev_node = new_node;
-        }
+    }
 
-        insert_nodes(cend(), other.size(), first, prev_node);
+    template<class T, class Alloc>
+    list<T, Alloc>::list(const list& other, const Alloc& alloc): list(alloc) {
+        if (other.empty()) return;
+        auto [first, last] = copy_nodes(other.cbegin(), other.size());
+        insert_nodes(cend(), other.size(), first, last);
     }
 
     template<class T, class Alloc>
     list<T, Alloc>::list(list&& other): size_(0), head_(), tail_(), node_alloc_(std::move(other.node_alloc_)) {
-        clear_ends(other.size_);
-        head_.connect(other.head_.next);
-        other.tail_.prev->connect(&tail_);
+        clear_ends();
+        swap_nodes(other);
+    }
 
-        other.clear_ends();
+    template<class T, class Alloc>
+    list<T, Alloc>::list(list&& other, const Alloc& alloc): list(alloc) {
+        if (node_alloc_ == other.node_alloc_) {
+            swap_nodes(other);
+        } else {
+            insert(cend(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
     }
 
     template<class T, class Alloc>
     list<T, Alloc>& list<T, Alloc>::operator=(const list& other) {
         if (this == &other) return *this;
 
-        list temp(other);
-        temp.swap(*this);
+        if constexpr (node_traits::propagate_on_container_copy_assignment::value) {
+            // Nodes go back to the allocator that made them.
+            if (node_alloc_ != other.node_alloc_) clear();
+            node_alloc_ = other.node_alloc_;
+        }
+        assign(other.cbegin(), other.cend());
 
         return *this;
     }
@@ -355,15 +646,52 @@ namespace task {
     list<T, Alloc>& list<T, Alloc>::operator=(list&& other) {
         if (this == &other) return *this;
 
-        clear();
-        other.swap(*this);
+        if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+            clear();
+            node_alloc_ = std::move(other.node_alloc_);
+            swap_nodes(other);
+        } else if (node_alloc_ == other.node_alloc_) {
+            clear();
+            swap_nodes(other);
+        } else {
+            assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
 
         return *this;
     }
 
+    template<class T, class Alloc>
+    void list<T, Alloc>::assign(size_t count, const T& value) {
+        auto it = begin();
+        for (; it != end() and count != 0; ++it, --count) {
+            *it = value;
+        }
+
+        if (count != 0) {
+            insert(cend(), count, value);
+        } else {
+            truncate(it);
+        }
+    }
+
+    template<class T, class Alloc>
+    template <class InputIt, class>
+    void list<T, Alloc>::assign(InputIt first, InputIt last) {
+        auto it = begin();
+        for (; it != end() and first != last; ++it, ++first) {
+            *it = *first;
+        }
+
+        if (first != last) {
+            insert(cend(), first, last);
+        } else {
+            truncate(it);
+        }
+    }
+
     template<class T, class Alloc>
     Alloc list<T, Alloc>::get_allocator() const {
-        return Alloc();
+        return Alloc(node_alloc_);
     }
 
     template<class T, class Alloc>
@@ -470,15 +798,54 @@ namespace task {
 
     template<class T, class Alloc>
     typename list<T, Alloc>::iterator list<T, Alloc>::insert(const_iterator pos, size_t count, const T& value) {
+        if (count == 0) return {pos.node_};
+
         auto [first, last] = create_nodes(count, value);
         insert_nodes(pos, count, first, last);
 
         return {first};
     }
 
+    // Forward ranges are counted first and their nodes taken in bulk; input
+    // ranges are linked as they are read. Either way the new nodes go into
+    // the list with one splice.
+    template<class T, class Alloc>
+    template <class InputIt, class>
+    typename list<T, Alloc>::iterator list<T, Alloc>::insert(const_iterator pos, InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+        if constexpr (std::is_convertible<Category, std::forward_iterator_tag>::value) {
+            auto count = static_cast<size_t>(std::distance(first, last));
+            if (count == 0) return {pos.node_};
+
+            auto [head, tail] = copy_nodes(first, count);
+            insert_nodes(pos, count, head, tail);
+            return {head};
+        } else {
+            if (first == last) return {pos.node_};
+
+            auto [head, tail] = create_nodes(1, *first);
+            size_t count = 1;
+            try {
+                for (++first; first != last; ++first, ++count) {
+                    auto node = create_nodes(1, *first).first;
+                    tail->connect(node);
+                    tail = node;
+                }
+            } catch (...) {
+                delete_chain(head);
+                throw;
+            }
+
+            insert_nodes(pos, count, head, tail);
+            return {head};
+        }
+    }
+
     template<class T, class Alloc>
     typename list<T, Alloc>::iterator list<T, Alloc>::erase(const_iterator pos) {
         auto node = pos.node_;
+        if (index_) index_erase(node);
         auto next = node->next;
         node->prev->connect(next);
         --size_;
@@ -496,6 +863,27 @@ namespace task {
         return {last.node_};
     }
 
+    template<class T, class Alloc>
+    typename list<T, Alloc>::node_type list<T, Alloc>::extract(const_iterator pos) {
+        auto node = pos.node_;
+        if (index_) index_erase(node);
+        node->prev->connect(node->next);
+        --size_;
+
+        return node_type(static_cast<Node*>(node), node_alloc_);
+    }
+
+    template<class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::insert(const_iterator pos, node_type&& node) {
+        if (node.empty()) return {pos.node_};
+        // The node is relinked as is, so it must come from an equal allocator.
+        assert(node.get_allocator() == get_allocator());
+
+        auto res = node.release();
+        insert_nodes(pos, 1, res, res);
+        return {res};
+    }
+
     template<class T, class Alloc>
     void list<T, Alloc>::push_back(const T& value) {
         insert(cend(), value);
@@ -552,27 +940,23 @@ namespace task {
             auto [first, last] = create_nodes(count - size_);
             insert_nodes(cend(), count - size_, first, last);
         } else if (count < size_) {
-            auto node = &head_;
-            for (size_t i = 0; i < count + 1; ++i) {
-                node = node->next;
-            }
-            auto node_last = node->prev;
-
-            while (node != &tail_) {
-                node = node->next;
-                delete_node(node->prev);
-            }
-
-            node_last->connect(&tail_);
+            truncate(nth(count));
         }
-
-        size_ = count;
     }
 
     template<class T, class Alloc>
     void list<T, Alloc>::swap(list& other) {
+        if constexpr (node_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(node_alloc_, other.node_alloc_);
+        }
+        swap_nodes(other);
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::swap_nodes(list& other) {
         std::swap(size_, other.size_);
-        std::swap(node_alloc_, other.node_alloc_);
+        std::swap(index_, other.index_);
 
         if (size_ != 0 || other.size_ != 0) {
             std::swap(head_, other.head_);
@@ -596,42 +980,30 @@ namespace task {
 
     template<class T, class Alloc>
     void list<T, Alloc>::merge(list& other) {
-        if (this == &other) return;
-
-        BaseNode* prev = nullptr;
-        BaseNode* begin = nullptr;
-
-        auto it1 = this->begin();
-        auto it2 = other.begin();
-        auto end1 = this->end();
-        auto end2 = other.end();
-
-        while (it1 != end1 or it2 != end2) {
-            BaseNode* node = nullptr;
-            if (it1 != end1 and it2 != end2) {
-                node =  static_cast<Node*>(it2.node_)->value < static_cast<Node*>(it1.node_)->value ?
-                        (it2++).node_ : (it1++).node_;
-            } else if (it1 != end1) {
-                node = (it1++).node_;
-            } else if (it2 != end2) {
-                node = (it2++).node_;
-            }
+        merge(other, std::less<T>());
+    }
 
-            if (prev == nullptr) {
-                begin = node;
-            } else {
-                prev->connect(node);
-            }
+    template<class T, class Alloc>
+    template <class Compare>
+    void list<T, Alloc>::merge(list& other, Compare comp) {
+        if (this == &other or other.empty()) return;
 
-            prev = node;
-        }
+        tail_.prev->next = nullptr;
+        other.tail_.prev->next = nullptr;
+        auto first = empty() ? nullptr : head_.next;
+        auto second = other.head_.next;
 
         auto new_size = size_ + other.size_;
-
-        clear_ends();
         other.clear_ends();
-
-        insert_nodes(cend(), new_size, begin, prev);
+        try {
+            merge_chains(first, second, comp);
+        } catch (...) {
+            relink_chain(first);
+            size_ = new_size;
+            throw;
+        }
+        relink_chain(first);
+        size_ = new_size;
     }
 
     template<class T, class Alloc>
@@ -642,19 +1014,72 @@ namespace task {
     }
 
     template<class T, class Alloc>
-    void list<T, Alloc>::remove(const T& value) {
-        for (auto it = cbegin(); it != cend(); ) {
-            if (*it == value)
-                it = erase(it);
-            else
-                ++it;
+    void list<T, Alloc>::splice(const_iterator pos, list& other, const_iterator it) {
+        auto node = it.node_;
+        if (pos.node_ == node or pos.node_ == node->next) return;
+
+        if (other.index_) other.index_erase(node);
+        node->prev->connect(node->next);
+        --other.size_;
+        insert_nodes(pos, 1, node, node);
+    }
+
+    // Nodes are relinked, never copied. Within one list the size does not
+    // change, so only moves between lists pay for counting the range.
+    template<class T, class Alloc>
+    void list<T, Alloc>::splice(const_iterator pos, list& other, const_iterator first, const_iterator last) {
+        if (first == last) return;
+
+        size_t count = this == &other ? 0 : std::distance(first, last);
+        auto first_node = first.node_;
+        auto last_node = last.node_->prev;
+
+        index_invalidate();
+        other.index_invalidate();
+
+        first_node->prev->connect(last.node_);
+        other.size_ -= count;
+        insert_nodes(pos, count, first_node, last_node);
+    }
+
+    template<class T, class Alloc>
+    size_t list<T, Alloc>::remove(const T& value) {
+        // Safe when `value` is an element: nothing is destroyed before the
+        // pass is over.
+        return remove_if([&value](const T& item) { return item == value; });
+    }
+
+    // Matching nodes are unlinked onto a private chain in one pass and freed
+    // together afterwards, so the scan is not interleaved with destructor and
+    // allocator calls.
+    template<class T, class Alloc>
+    template <class UnaryPredicate>
+    size_t list<T, Alloc>::remove_if(UnaryPredicate pred) {
+        BaseNode* removed = nullptr;
+        size_t count = 0;
+        for (auto node = head_.next; node != &tail_; ) {
+            auto next = node->next;
+            if (pred(value_of(node))) {
+                node->prev->connect(next);
+                node->next = removed;
+                removed = node;
+                ++count;
+            }
+            node = next;
         }
+
+        if (count != 0) index_invalidate();
+        size_ -= count;
+        delete_chain(removed);
+        return count;
     }
 
     template<class T, class Alloc>
     void list<T, Alloc>::reverse() {
         if (size_ < 2) return;
 
+        index_invalidate();
+
         for (auto node = head_.next; node != &tail_; node = node->prev) {
             std::swap(node->next, node->prev);
         }
@@ -666,40 +1091,340 @@ namespace task {
     }
 
     template<class T, class Alloc>
-    void list<T, Alloc>::unique() {
-        if (size_ < 2) return;
+    size_t list<T, Alloc>::unique() {
+        return unique(std::equal_to<T>());
+    }
 
-        auto prev_it = cbegin();
-        for (auto it = ++cbegin(); it != cend();) {
-            if (*it == *prev_it) {
-                it = erase(it);
-            }
-            else {
-                prev_it = it++;
+    template<class T, class Alloc>
+    template <class BinaryPredicate>
+    size_t list<T, Alloc>::unique(BinaryPredicate pred) {
+        if (size_ < 2) return 0;
+
+        BaseNode* removed = nullptr;
+        size_t count = 0;
+        auto kept = head_.next;
+        for (auto node = kept->next; node != &tail_; ) {
+            auto next = node->next;
+            if (pred(value_of(kept), value_of(node))) {
+                kept->connect(next);
+                node->next = removed;
+                removed = node;
+                ++count;
+            } else {
+                kept = node;
             }
+            node = next;
         }
+
+        if (count != 0) index_invalidate();
+        size_ -= count;
+        delete_chain(removed);
+        return count;
     }
 
+    template<class T, class Alloc>
+    void list<T, Alloc>::compact() {
+        compact(cbegin(), size_);
+    }
+
+    template<class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::compact(const_iterator pos, size_t max_nodes) {
+        auto node = pos.node_;
+        if (node == &tail_ or max_nodes == 0) return {node};
+
+        index_invalidate();
+
+        // Without a pool, every replacement is allocated before any old node
+        // is freed, or the allocator would hand the freed blocks straight
+        // back and leave the layout as it was.
+        std::vector<Node*> fresh;
+        if constexpr (not kNodePool) {
+            size_t count = 0;
+            for (auto it = node; it != &tail_ and count < max_nodes; it = it->next) {
+                ++count;
+            }
+
+            fresh.reserve(count);
+            try {
+                for (size_t i = 0; i < count; ++i) {
+                    fresh.push_back(node_traits::allocate(node_alloc_, 1));
+                }
+            } catch (...) {
+                for (auto unused: fresh) {
+                    node_traits::deallocate(node_alloc_, unused, 1);
+                }
+                throw;
+            }
+            max_nodes = count;
+        }
+
+        NodeRun run;
+        // Returns the replacements not used from step `first` on.
+        auto release_unused = [&](size_t first) {
+            if (run.left != 0) {
+                node_traits::deallocate(node_alloc_, run.next, run.left);
+            }
+            for (auto i = first; i < fresh.size(); ++i) {
+                node_traits::deallocate(node_alloc_, fresh[i], 1);
+            }
+        };
+
+        for (size_t i = 0; i < max_nodes and node != &tail_; ++i) {
+            Node* moved;
+            if constexpr (kNodePool) {
+                // Fresh slab memory only: recycled nodes are wherever the old
+                // ones were.
+                if (run.left == 0) {
+                    run.left = std::min(max_nodes - i, kCompactRun);
+                    run.next = node_alloc_.allocate_fresh(run.left);
+                }
+                --run.left;
+                moved = run.next++;
+            } else {
+                moved = fresh[i];
+            }
+
+            auto old = static_cast<Node*>(node);
+            try {
+                node_traits::construct(node_alloc_, moved, std::move(old->value));
+            } catch (...) {
+                node_traits::deallocate(node_alloc_, moved, 1);
+                release_unused(i + 1);
+                throw;
+            }
+            old->prev->connect(moved);
+            moved->connect(old->next);
+            node = old->next;
+            delete_node(old);
+        }
+
+        // A run cut short by the end of the list goes back to the pool.
+        release_unused(fresh.size());
+
+        return {node};
+    }
 
     template<class T, class Alloc>
     void list<T, Alloc>::sort() {
+        sort(std::less<T>());
+    }
+
+    template<class T, class Alloc>
+    template <class Compare>
+    void list<T, Alloc>::sort(Compare comp) {
         if (size_ < 2)
             return;
 
-        auto half_size = size_ / 2;
-        auto it = begin();
-        std::advance(it, half_size - 1);
+        auto first = head_.next;
+        tail_.prev->next = nullptr;
+        try {
+            sort_chain(first, comp);
+        } catch (...) {
+            relink_chain(first);
+            throw;
+        }
+        relink_chain(first);
+    }
 
-        list temp;
-        temp.insert_nodes(temp.cend(), size_ - half_size, it.node_->next, tail_.prev);
+    template<class T, class Alloc>
+    template <class Compare>
+    void list<T, Alloc>::parallel_sort(Compare comp, thread_pool& pool) {
+        constexpr size_t kMinRun = 1 << 14;
+        auto runs_count = std::min(pool.size() + 1, size_ / kMinRun);
+        if (runs_count < 2) {
+            sort(comp);
+            return;
+        }
 
-        it.node_->connect(&tail_);
-        size_ = half_size;
+        auto runs = split_points(runs_count);
+        for (size_t i = 1; i <= runs_count; ++i) {
+            runs[i]->prev->next = nullptr;
+        }
+        runs.pop_back();
+
+        // Tasks must not throw, so they keep the exception of a failed
+        // comparison; the runs are then linked back before it is rethrown.
+        std::vector<std::exception_ptr> errors(runs.size());
+        auto rethrow = [&] {
+            for (auto& error: errors) {
+                if (not error) continue;
+
+                BaseNode* first = nullptr;
+                for (auto it = runs.rbegin(); it != runs.rend(); ++it) {
+                    first = join_chains(*it, first);
+                }
+                relink_chain(first);
+                std::rethrow_exception(error);
+            }
+        };
+
+        pool.parallel_for(runs.size(), [&](size_t i) {
+            try {
+                auto run_comp = comp;
+                sort_chain(runs[i], run_comp);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        rethrow();
+
+        // Neighbouring runs merge pairwise, earlier run first, which keeps the
+        // result stable. The last round is a single serial merge.
+        while (runs.size() > 1) {
+            std::vector<BaseNode*> merged((runs.size() + 1) / 2);
+            errors.assign(runs.size() / 2, nullptr);
+            pool.parallel_for(runs.size() / 2, [&](size_t i) {
+                try {
+                    auto run_comp = comp;
+                    merge_chains(runs[2 * i], runs[2 * i + 1], run_comp);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+                merged[i] = runs[2 * i];
+            });
+            if (runs.size() % 2 != 0) {
+                merged.back() = runs.back();
+            }
+            runs.swap(merged);
+            rethrow();
+        }
+
+        relink_chain(runs.front());
+    }
+
+    template<class T, class Alloc>
+    template <class Function>
+    void list<T, Alloc>::parallel_for_each(Function f, thread_pool& pool) {
+        run_chunks(chunk_count(pool), pool, [&f](size_t, BaseNode* first, BaseNode* last) {
+            for (auto node = first; node != last; node = node->next) {
+                f(static_cast<Node*>(node)->value);
+            }
+        });
+    }
+
+    template<class T, class Alloc>
+    template <class UnaryOperation>
+    void list<T, Alloc>::parallel_transform(UnaryOperation op, thread_pool& pool) {
+        run_chunks(chunk_count(pool), pool, [&op](size_t, BaseNode* first, BaseNode* last) {
+            for (auto node = first; node != last; node = node->next) {
+                auto& value = static_cast<Node*>(node)->value;
+                value = op(value);
+            }
+        });
+    }
+
+    // Every chunk is folded from its own first element, so `op` needs no
+    // identity; the partial results are then folded onto `init` in order.
+    template<class T, class Alloc>
+    template <class U, class BinaryOperation>
+    U list<T, Alloc>::parallel_reduce(U init, BinaryOperation op, thread_pool& pool) const {
+        if (empty()) return init;
+
+        auto chunks = chunk_count(pool);
+        std::vector<std::optional<U>> partial(chunks);
+        run_chunks(chunks, pool, [&](size_t i, BaseNode* first, BaseNode* last) {
+            U res(value_of(first));
+            for (auto node = first->next; node != last; node = node->next) {
+                res = op(std::move(res), value_of(node));
+            }
+            partial[i].emplace(std::move(res));
+        });
+
+        for (auto& res: partial) {
+            init = op(std::move(init), std::move(*res));
+        }
+        return init;
+    }
+
+    template<class T, class Alloc>
+    size_t list<T, Alloc>::chunk_count(const thread_pool& pool) const {
+        return std::max<size_t>(1, std::min(size_ / kMinChunk, (pool.size() + 1) * kChunksPerThread));
+    }
+
+    template<class T, class Alloc>
+    std::vector<typename list<T, Alloc>::BaseNode*> list<T, Alloc>::split_points(size_t chunks) const {
+        std::vector<BaseNode*> points(chunks + 1);
+        points[chunks] = const_cast<BaseNode*>(&tail_);
+
+        auto length = size_ / chunks;
+        auto longer = size_ % chunks;
+        if (index_) {
+            // O(sqrt(n)) per point instead of a walk over the whole list.
+            for (size_t i = 0; i < chunks; ++i) {
+                points[i] = nth(i * length + std::min(i, longer)).node_;
+            }
+            return points;
+        }
+
+        auto node = head_.next;
+        for (size_t i = 0; i < chunks; ++i) {
+            points[i] = node;
+            for (size_t j = 0; j < length + (i < longer ? 1 : 0); ++j) {
+                node = node->next;
+            }
+        }
+        return points;
+    }
+
+    template<class T, class Alloc>
+    template <class Body>
+    void list<T, Alloc>::run_chunks(size_t chunks, thread_pool& pool, Body body) const {
+        if (chunks == 1) {
+            body(0, head_.next, const_cast<BaseNode*>(&tail_));
+            return;
+        }
+
+        auto points = split_points(chunks);
+        pool.parallel_for(chunks, [&](size_t i) {
+            body(i, points[i], points[i + 1]);
+        });
+    }
+
+    // Bottom-up merge sort. bins[i] holds a sorted chain of 2^i nodes or is
+    // empty; every node is carried up through the occupied bins like a binary
+    // counter increment, then the bins are merged together. Only pointers
+    // move: no temporary lists, allocations or walks to a midpoint.
+    template<class T, class Alloc>
+    template <class Compare>
+    void list<T, Alloc>::sort_chain(BaseNode*& first, Compare& comp) {
+        BaseNode* bins[64] = {};
+        size_t used = 0;
+
+        // Every node is at all times either in `first` or in a bin, so a
+        // throwing comparison loses none of them.
+        try {
+            while (first != nullptr) {
+                auto carry = first;
+                first = first->next;
+                carry->next = nullptr;
+
+                // Bins hold earlier nodes than the carry, so they merge first.
+                size_t i = 0;
+                for (; i < used and bins[i] != nullptr; ++i) {
+                    merge_chains(bins[i], carry, comp);
+                    carry = bins[i];
+                    bins[i] = nullptr;
+                }
 
-        sort();
-        temp.sort();
+                bins[i] = carry;
+                used = std::max(used, i + 1);
+            }
 
-        merge(temp);
+            for (size_t i = 0; i < used; ++i) {
+                if (bins[i] != nullptr) {
+                    auto later = first;
+                    first = nullptr;
+                    merge_chains(bins[i], later, comp);
+                    first = bins[i];
+                    bins[i] = nullptr;
+                }
+            }
+        } catch (...) {
+            for (size_t i = 0; i < used; ++i) {
+                first = join_chains(bins[i], first);
+            }
+            throw;
+        }
     }
 
     template<class T, class Alloc>
@@ -707,6 +1432,30 @@ namespace task {
         tail_.prev = &head_;
         head_.next = &tail_;
         size_ = new_size;
+
+        // An empty list has an empty, valid index.
+        if (index_) {
+            index_->blocks.clear();
+            index_->block_of.clear();
+            index_->stale = new_size != 0;
+        }
+    }
+
+    template<class T, class Alloc>
+    typename list<T, Alloc>::Node* list<T, Alloc>::take_node(NodeRun& run, size_t remaining) {
+        if (run.left == 0) {
+            run.left = 1;
+            if constexpr (kNodePool) {
+                // Recycled nodes go first, fresh runs only once they run out.
+                if (!node_alloc_.has_recycled()) {
+                    run.left = std::min(remaining, kNodeRun);
+                }
+            }
+            run.next = node_traits::allocate(node_alloc_, run.left);
+        }
+
+        --run.left;
+        return run.next++;
     }
 
     template<class T, class Alloc>
@@ -715,9 +1464,15 @@ namespace task {
     list<T, Alloc>::create_nodes(size_t count, Args&&... args) {
         Node* prev = nullptr;
         Node* first = nullptr;
+        NodeRun run;
         for (size_t i = 0; i < count; ++i) {
-            Node* node = node_alloc_.allocate(1);
-            node_alloc_.construct(node, std::forward<Args>(args)...);
+            Node* node = take_node(run, count - i);
+            try {
+                node_traits::construct(node_alloc_, node, std::forward<Args>(args)...);
+            } catch (...) {
+                discard_nodes(run, first, node);
+                throw;
+            }
             node->prev = prev;
             if (prev) {
                 prev->connect(node);
@@ -732,11 +1487,127 @@ namespace task {
         return std::make_pair(first, prev);
     }
 
+    template<class T, class Alloc>
+    template <class InputIt>
+    std::pair<typename list<T, Alloc>::Node* , typename list<T, Alloc>::Node* >
+    list<T, Alloc>::copy_nodes(InputIt first, size_t count) {
+        Node* prev = nullptr;
+        Node* head = nullptr;
+        NodeRun run;
+        for (size_t i = 0; i < count; ++i, ++first) {
+            Node* node = take_node(run, count - i);
+            try {
+                node_traits::construct(node_alloc_, node, *first);
+            } catch (...) {
+                discard_nodes(run, head, node);
+                throw;
+            }
+            node->prev = prev;
+            if (prev) {
+                prev->connect(node);
+            }
+            else {
+                head = node;
+            }
+
+            prev = node;
+        }
+
+        return std::make_pair(head, prev);
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::discard_nodes(NodeRun& run, Node* first, Node* failed) {
+        delete_chain(first);
+        node_traits::deallocate(node_alloc_, failed, 1);
+        if (run.left != 0) {
+            node_traits::deallocate(node_alloc_, run.next, run.left);
+            run.left = 0;
+        }
+    }
+
     template<class T, class Alloc>
     void list<T, Alloc>::delete_node(BaseNode* base_node) {
         auto node = static_cast<Node*>(base_node);
-        node_alloc_.destroy(node);
-        node_alloc_.deallocate(node, 1);
+        node_traits::destroy(node_alloc_, node);
+        node_traits::deallocate(node_alloc_, node, 1);
+    }
+
+    template<class T, class Alloc>
+    template <class Compare>
+    void list<T, Alloc>::merge_chains(BaseNode*& first, BaseNode* second, Compare& comp) {
+        BaseNode res;
+        BaseNode* last = &res;
+        auto rest = first;
+        try {
+            while (rest and second) {
+                if (comp(value_of(second), value_of(rest))) {
+                    last->next = second;
+                    second = second->next;
+                } else {
+                    last->next = rest;
+                    rest = rest->next;
+                }
+                last = last->next;
+            }
+        } catch (...) {
+            last->next = join_chains(rest, second);
+            first = res.next;
+            throw;
+        }
+
+        last->next = rest ? rest : second;
+        first = res.next;
+    }
+
+    template<class T, class Alloc>
+    typename list<T, Alloc>::BaseNode* list<T, Alloc>::join_chains(BaseNode* first, BaseNode* second) {
+        if (first == nullptr) return second;
+
+        auto last = first;
+        while (last->next != nullptr) {
+            last = last->next;
+        }
+        last->next = second;
+        return first;
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::relink_chain(BaseNode* first) {
+        index_invalidate();
+
+        BaseNode* prev = &head_;
+        for (auto node = first; node != nullptr; node = node->next) {
+            node->prev = prev;
+            prev = node;
+        }
+
+        head_.next = first ? first : &tail_;
+        prev->connect(&tail_);
+    }
+
+    template<class T, class Alloc>
+    size_t list<T, Alloc>::delete_chain(BaseNode* first) {
+        size_t count = 0;
+        while (first != nullptr) {
+            auto next = first->next;
+            delete_node(first);
+            first = next;
+            ++count;
+        }
+
+        return count;
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::truncate(const_iterator pos) {
+        auto first = pos.node_;
+        if (first == &tail_) return;
+
+        index_invalidate();
+        tail_.prev->next = nullptr;
+        first->prev->connect(&tail_);
+        size_ -= delete_chain(first);
     }
 
     template<class T, class Alloc>
@@ -748,6 +1619,220 @@ namespace task {
         last->connect(tail_node);
 
         size_ += count;
+        if (index_ and count != 0) index_insert(head_node, count, first);
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::enable_index(bool enabled) {
+        if (not enabled) {
+            index_.reset();
+        } else if (not index_) {
+            index_ = std::make_unique<PositionIndex>();
+        }
+    }
+
+    template<class T, class Alloc>
+    bool list<T, Alloc>::index_enabled() const {
+        return index_ != nullptr;
+    }
+
+    template<class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::nth(size_t pos) {
+        return {static_cast<const list*>(this)->nth(pos).node_};
+    }
+
+    template<class T, class Alloc>
+    typename list<T, Alloc>::const_iterator list<T, Alloc>::nth(size_t pos) const {
+        if (pos >= size_) return cend();
+
+        BaseNode* node = nullptr;
+        if (index_) {
+            index_refresh();
+
+            size_t block = 0;
+            while (pos >= index_->blocks[block].count) {
+                pos -= index_->blocks[block++].count;
+            }
+            node = index_->blocks[block].anchor;
+        } else if (pos < size_ / 2) {
+            node = head_.next;
+        } else {
+            // Walks back from the end.
+            node = const_cast<BaseNode*>(&tail_);
+            for (; pos < size_; ++pos) {
+                node = node->prev;
+            }
+            return {node};
+        }
+
+        for (; pos != 0; --pos) {
+            node = node->next;
+        }
+        return {node};
+    }
+
+    template<class T, class Alloc>
+    size_t list<T, Alloc>::position(const_iterator it) const {
+        if (it.node_ == &tail_) return size_;
+
+        if (not index_) {
+            size_t res = 0;
+            for (auto node = it.node_; node != head_.next; node = node->prev) {
+                ++res;
+            }
+            return res;
+        }
+
+        index_refresh();
+
+        size_t offset;
+        auto block = index_locate(it.node_, offset);
+        for (size_t i = 0; i < block; ++i) {
+            offset += index_->blocks[i].count;
+        }
+        return offset;
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_refresh() const {
+        auto& index = *index_;
+        if (not index.stale) return;
+
+        std::lock_guard<std::mutex> lock(index.rebuild_mutex);
+        if (index.stale) index_rebuild();
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_rebuild() const {
+        auto& index = *index_;
+        index.block_size = std::max<size_t>(64, std::sqrt(size_));
+        index.blocks.clear();
+
+        auto node = head_.next;
+        for (size_t left = size_; left != 0; ) {
+            auto count = std::min(left, index.block_size);
+            index.blocks.push_back({node, count});
+            for (size_t i = 0; i < count; ++i) {
+                node = node->next;
+            }
+            left -= count;
+        }
+
+        index_renumber();
+        index.stale = false;
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_renumber() const {
+        auto& index = *index_;
+        index.block_of.clear();
+        for (size_t i = 0; i < index.blocks.size(); ++i) {
+            index.block_of[index.blocks[i].anchor] = i;
+        }
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_invalidate() {
+        if (index_) index_->stale = true;
+    }
+
+    template<class T, class Alloc>
+    size_t list<T, Alloc>::index_locate(const BaseNode* node, size_t& offset) const {
+        const auto& block_of = index_->block_of;
+        offset = 0;
+        auto it = block_of.find(node);
+        while (it == block_of.end()) {
+            node = node->prev;
+            ++offset;
+            it = block_of.find(node);
+        }
+        return it->second;
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_insert(BaseNode* prev, size_t count, BaseNode* first) {
+        auto& index = *index_;
+        if (index.stale) return;
+
+        size_t block = 0;
+        if (index.blocks.empty()) {
+            // index_rebuild sizes the blocks for the new contents.
+            index.stale = true;
+            return;
+        } else if (prev == &head_) {
+            // The new nodes open the first block.
+            index.block_of.erase(index.blocks.front().anchor);
+            index.blocks.front().anchor = first;
+            index.block_of[first] = 0;
+        } else {
+            size_t offset;
+            block = index_locate(prev, offset);
+        }
+
+        index.blocks[block].count += count;
+        if (index.blocks[block].count > 2 * index.block_size) {
+            index_split(block);
+        }
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_erase(BaseNode* node) {
+        auto& index = *index_;
+        if (index.stale) return;
+
+        size_t offset;
+        auto block = index_locate(node, offset);
+        auto& blocks = index.blocks;
+        --blocks[block].count;
+
+        if (offset == 0) {
+            index.block_of.erase(node);
+            if (blocks[block].count == 0) {
+                blocks.erase(blocks.begin() + block);
+                index_renumber();
+                return;
+            }
+            blocks[block].anchor = node->next;
+            index.block_of[node->next] = block;
+        }
+
+        // An underfilled block takes over the nodes of the next one when
+        // both fit in a single block.
+        if (blocks[block].count < index.block_size / 2 and block + 1 < blocks.size() and
+            blocks[block].count + blocks[block + 1].count <= 2 * index.block_size) {
+            blocks[block].count += blocks[block + 1].count;
+            index.block_of.erase(blocks[block + 1].anchor);
+            blocks.erase(blocks.begin() + block + 1);
+            index_renumber();
+        }
+    }
+
+    template<class T, class Alloc>
+    void list<T, Alloc>::index_split(size_t block) {
+        auto& index = *index_;
+        auto& blocks = index.blocks;
+        auto node = blocks[block].anchor;
+        auto left = blocks[block].count;
+
+        std::vector<typename PositionIndex::Block> pieces;
+        while (left != 0) {
+            auto count = std::min(left, index.block_size);
+            pieces.push_back({node, count});
+            for (size_t i = 0; i < count; ++i) {
+                node = node->next;
+            }
+            left -= count;
+        }
+
+        blocks.erase(blocks.begin() + block);
+        blocks.insert(blocks.begin() + block, pieces.begin(), pieces.end());
+
+        // Far more blocks than their size means the list outgrew block_size.
+        if (blocks.size() > 4 * index.block_size) {
+            index.stale = true;
+        } else {
+            index_renumber();
+        }
     }
 
 }  // namespace task
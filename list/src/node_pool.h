@@ -0,0 +1,253 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+
+namespace task {
+
+    // Slab arena for fixed-size blocks. Memory is carved out of large slabs by
+    // bumping a pointer, and released blocks go to a free list of their size
+    // and alignment that later allocations of the same kind pop first. Slabs
+    // are returned to the system only when the pool is destroyed.
+    //
+    // A run of `n` blocks handed out at once may be released block by block,
+    // which is what lets a container allocate many nodes in one call and free
+    // them individually later. Blocks smaller than a pointer are the
+    // exception: they are rounded up, and a run of them goes back whole. The
+    // pool is not thread-safe.
+    class NodePool {
+    public:
+        explicit NodePool(size_t slab_bytes = 1 << 16): slab_bytes_(slab_bytes), cur_(nullptr), end_(nullptr) {
+
+        }
+
+        NodePool(const NodePool&) = delete;
+        NodePool& operator=(const NodePool&) = delete;
+
+        ~NodePool() {
+            for (auto slab: slabs_) {
+                ::operator delete(slab);
+            }
+        }
+
+        // Returns `count` contiguous blocks of `size` bytes aligned to `align`.
+        void* allocate(size_t size, size_t align, size_t count = 1) {
+            if (count == 1) {
+                auto& list = free_list(size, align);
+                if (list.head) {
+                    auto block = list.head;
+                    list.head = next_of(block);
+                    return block;
+                }
+            }
+
+            return carve(run_bytes(size, count), align);
+        }
+
+        // Same as allocate, but never reuses released blocks: the run always
+        // comes from the end of the current slab or from a fresh one.
+        void* allocate_fresh(size_t size, size_t align, size_t count) {
+            return carve(run_bytes(size, count), align);
+        }
+
+        void deallocate(void* ptr, size_t size, size_t align, size_t count = 1) {
+            auto& list = free_list(size, align);
+
+            // Small blocks come back as pointer-sized pieces of the run, each
+            // of which can serve one rounded-up allocation.
+            auto stride = std::max(size, sizeof(void*));
+            auto bytes = static_cast<char*>(ptr);
+            for (size_t i = 0, blocks = run_bytes(size, count) / stride; i < blocks; ++i) {
+                auto block = bytes + i * stride;
+                set_next(block, list.head);
+                list.head = block;
+            }
+        }
+
+        bool has_recycled(size_t size, size_t align) const {
+            for (auto& list: free_lists_) {
+                if (list.size == size && list.align == align) return list.head != nullptr;
+            }
+            return false;
+        }
+
+        size_t slab_count() const {
+            return slabs_.size();
+        }
+
+    private:
+        // Blocks of one size carved for a weaker alignment may be misaligned
+        // for a stricter one, so every (size, alignment) pair has its own
+        // list. A pool serves a handful of node types; a linear search is
+        // enough.
+        struct FreeList {
+            size_t size;
+            size_t align;
+            void* head;
+        };
+
+        FreeList& free_list(size_t size, size_t align) {
+            for (auto& list: free_lists_) {
+                if (list.size == size && list.align == align) return list;
+            }
+            free_lists_.push_back({size, align, nullptr});
+            return free_lists_.back();
+        }
+
+        // A released block stores the link to the next one in its first
+        // bytes, which need not be aligned for a pointer.
+        static void* next_of(void* block) {
+            void* next;
+            std::memcpy(&next, block, sizeof(next));
+            return next;
+        }
+
+        static void set_next(void* block, void* next) {
+            std::memcpy(block, &next, sizeof(next));
+        }
+
+        // Bytes taken by `count` blocks, rounded up to whole pointers.
+        static size_t run_bytes(size_t size, size_t count) {
+            if (size >= sizeof(void*)) return size * count;
+            return (size * count + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+        }
+
+        void* carve(size_t bytes, size_t align) {
+            auto aligned = cur_ ? align_up(cur_, align) : nullptr;
+            if (!aligned || aligned + bytes > end_) {
+                // Oversized runs get a dedicated slab and keep the current one.
+                auto slab_bytes = std::max(slab_bytes_, bytes + align);
+                auto slab = static_cast<char*>(::operator new(slab_bytes));
+                slabs_.push_back(slab);
+
+                aligned = align_up(slab, align);
+                if (bytes + align > slab_bytes_) {
+                    return aligned;
+                }
+
+                end_ = slab + slab_bytes;
+            }
+
+            cur_ = aligned + bytes;
+            return aligned;
+        }
+
+        static char* align_up(char* ptr, size_t align) {
+            auto address = reinterpret_cast<std::uintptr_t>(ptr);
+            return ptr + (align - address % align) % align;
+        }
+
+        size_t slab_bytes_;
+        char* cur_;
+        char* end_;
+        std::vector<char*> slabs_;
+        std::vector<FreeList> free_lists_;
+    };
+
+
+    // Allocator handle over a shared NodePool. Copies and rebinds share the
+    // pool, so a list and the lists copied from it, or several lists built
+    // from one allocator, draw nodes from the same arena.
+    template<class T>
+    class PoolAllocator {
+    public:
+        using value_type = T;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using reference = T&;
+        using const_reference = const T&;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+
+        // Marks allocators whose multi-element runs may be freed one element
+        // at a time; task::list allocates nodes in bulk with those.
+        using is_node_pool = std::true_type;
+
+        // The pool travels with the nodes when a list is moved or swapped;
+        // a copy-assigned list keeps its own pool.
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        template<class U>
+        struct rebind {
+            using other = PoolAllocator<U>;
+        };
+
+        PoolAllocator(): pool_(std::make_shared<NodePool>()) {
+
+        }
+
+        explicit PoolAllocator(std::shared_ptr<NodePool> pool): pool_(std::move(pool)) {
+
+        }
+
+        // Moving an allocator must leave the source usable, so moves copy.
+        PoolAllocator(const PoolAllocator& other): pool_(other.pool_) {
+
+        }
+
+        template<class U>
+        PoolAllocator(const PoolAllocator<U>& other): pool_(other.pool()) {
+
+        }
+
+        PoolAllocator& operator=(const PoolAllocator& other) {
+            pool_ = other.pool_;
+            return *this;
+        }
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(pool_->allocate(sizeof(T), alignof(T), n));
+        }
+
+        T* allocate_fresh(size_t n) {
+            return static_cast<T*>(pool_->allocate_fresh(sizeof(T), alignof(T), n));
+        }
+
+        // True when allocate(1) will reuse a released block.
+        bool has_recycled() const {
+            return pool_->has_recycled(sizeof(T), alignof(T));
+        }
+
+        void deallocate(T* p, size_t n) {
+            pool_->deallocate(p, sizeof(T), alignof(T), n);
+        }
+
+        template<class... Args>
+        void construct(T* p, Args&&... args) {
+            ::new((void *)p) T(std::forward<Args>(args)...);
+        }
+
+        void destroy(T* p) {
+            p->~T();
+        }
+
+        const std::shared_ptr<NodePool>& pool() const {
+            return pool_;
+        }
+
+    private:
+        std::shared_ptr<NodePool> pool_;
+    };
+
+    template<class T, class U>
+    bool operator==(const PoolAllocator<T>& left, const PoolAllocator<U>& right) {
+        return left.pool() == right.pool();
+    }
+
+    template<class T, class U>
+    bool operator!=(const PoolAllocator<T>& left, const PoolAllocator<U>& right) {
+        return !(left == right);
+    }
+
+    template<class Alloc, class = void>
+    struct IsNodePool: std::false_type {};
+
+    template<class Alloc>
+    struct IsNodePool<Alloc, std::void_t<typename Alloc::is_node_pool>>: Alloc::is_node_pool {};
+
+}  // namespace task
@@ -0,0 +1,175 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace task {
+
+    // Fixed set of worker threads with a task deque each. A worker runs its
+    // own tasks newest first and, once out of work, steals the oldest task
+    // of another worker. Tasks submitted from a worker go to its own deque,
+    // tasks from other threads are dealt round-robin. A thread waiting in
+    // parallel_for runs tasks itself, so calls may nest without starving the
+    // pool.
+    class thread_pool {
+    public:
+        explicit thread_pool(size_t threads = default_size()): pending_(0), next_queue_(0), stop_(false) {
+            for (size_t i = 0; i < threads; ++i) {
+                queues_.push_back(std::make_unique<WorkQueue>());
+            }
+            for (size_t i = 0; i < threads; ++i) {
+                workers_.emplace_back([this, i] { work(i); });
+            }
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            has_tasks_.notify_all();
+
+            for (auto& worker: workers_) {
+                worker.join();
+            }
+        }
+
+        size_t size() const {
+            return workers_.size();
+        }
+
+        // Pool used by the parallel list algorithms when none is given.
+        static thread_pool& shared() {
+            static thread_pool pool;
+            return pool;
+        }
+
+        static size_t default_size() {
+            return std::max(1u, std::thread::hardware_concurrency()) - 1;
+        }
+
+        // Runs body(i) for every i in [0, count) and returns once all calls
+        // are done. The calling thread takes part in the work. `body` must
+        // not throw.
+        template <class Body>
+        void parallel_for(size_t count, Body&& body) {
+            if (count == 0) return;
+
+            if (queues_.empty()) {
+                for (size_t i = 0; i < count; ++i) {
+                    body(i);
+                }
+                return;
+            }
+
+            auto home = current_queue();
+            std::atomic<size_t> left(count);
+            // Counted before they are queued, so a sleeping worker never
+            // misses them; an early wake-up only finds nothing to steal.
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_ += count;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                auto& queue = *queues_[home != kNoQueue ? home : next_queue_++ % queues_.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.emplace_back([this, &body, &left, i] {
+                    body(i);
+                    if (--left == 0) {
+                        std::lock_guard<std::mutex> done_lock(mutex_);
+                        done_.notify_all();
+                    }
+                });
+            }
+            has_tasks_.notify_all();
+
+            while (left != 0) {
+                if (run_one(home)) continue;
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                done_.wait(lock, [&] { return left == 0 or pending_ != 0; });
+            }
+        }
+
+    private:
+        static constexpr size_t kNoQueue = static_cast<size_t>(-1);
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        // Queue of the calling thread if it is a worker of this pool.
+        size_t current_queue() const {
+            auto& current = worker_slot();
+            return current.first == this ? current.second : kNoQueue;
+        }
+
+        static std::pair<const thread_pool*, size_t>& worker_slot() {
+            static thread_local std::pair<const thread_pool*, size_t> slot(nullptr, kNoQueue);
+            return slot;
+        }
+
+        // Runs the newest task of queue `home`, or else steals the oldest
+        // task of another queue. Returns false if every queue was empty.
+        bool run_one(size_t home) {
+            std::function<void()> task;
+            if (home != kNoQueue) {
+                auto& queue = *queues_[home];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (not queue.tasks.empty()) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+            }
+
+            auto start = home != kNoQueue ? home + 1 : next_queue_.load();
+            for (size_t i = 0; i < queues_.size() and not task; ++i) {
+                auto& queue = *queues_[(start + i) % queues_.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (not queue.tasks.empty()) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+            }
+
+            if (not task) return false;
+
+            --pending_;
+            task();
+            return true;
+        }
+
+        void work(size_t index) {
+            worker_slot() = {this, index};
+            while (true) {
+                if (run_one(index)) continue;
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                has_tasks_.wait(lock, [this] { return stop_ or pending_ != 0; });
+                if (stop_ and pending_ == 0) return;
+            }
+        }
+
+        std::vector<std::unique_ptr<WorkQueue>> queues_;
+        std::atomic<size_t> pending_;
+        std::atomic<size_t> next_queue_;
+
+        // Guards sleeping and waking only; the tasks are in queues_.
+        std::mutex mutex_;
+        std::condition_variable has_tasks_;
+        std::condition_variable done_;
+        std::vector<std::thread> workers_;
+        bool stop_;
+    };
+
+}  // namespace task
@@ -0,0 +1,979 @@
+#pragma once
+#include <iterator>
+#include <memory>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace task {
+
+
+    // Unrolled doubly linked list: every node stores up to Capacity elements
+    // in an inline array, so a scan touches several elements per cache line
+    // and there is one allocation per Capacity elements instead of one per
+    // element. Insertion into a full node splits it in half; erasure, and the
+    // bulk removals remove_if and unique, merge a node with its neighbour once
+    // they fit together, which keeps insertion O(1) amortized and nodes at
+    // least partly filled.
+    //
+    // Unlike task::list, insert and erase invalidate iterators to the elements
+    // of the nodes they touch.
+    template<class T, size_t Capacity = std::max<size_t>(4, 240 / sizeof(T)), class Alloc = std::allocator<T>>
+    class unrolled_list {
+        static_assert(Capacity >= 2, "unrolled_list nodes need room for at least two elements");
+
+        struct BaseNode;
+        struct Node;
+
+    public:
+
+        class const_iterator;
+        class iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            iterator(): node_(nullptr), index_(0) {
+
+            }
+
+            iterator(BaseNode* node, size_t index): node_(node), index_(index) {
+
+            }
+
+            operator const_iterator() const {
+                return {node_, index_};
+            }
+
+            iterator& operator++() {
+                if (++index_ == node_->count) {
+                    node_ = node_->next;
+                    index_ = 0;
+                }
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator res(*this);
+                ++*this;
+                return res;
+            }
+
+            iterator& operator--() {
+                if (index_ == 0) {
+                    node_ = node_->prev;
+                    index_ = node_->count;
+                }
+                --index_;
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator res(*this);
+                --*this;
+                return res;
+            }
+
+            reference operator*() const {
+                return static_cast<Node*>(node_)->items()[index_];
+            }
+
+            pointer operator->() const {
+                return &static_cast<Node*>(node_)->items()[index_];
+            }
+
+            bool operator==(iterator other) const  {
+                return node_ == other.node_ and index_ == other.index_;
+            }
+
+            bool operator!=(iterator other) const {
+                return !(*this == other);
+            }
+
+        private:
+            friend class unrolled_list;
+            BaseNode* node_;
+            size_t index_;
+        };
+
+        class const_iterator {
+        public:
+            using difference_type = ptrdiff_t;
+            using value_type = T;
+            using pointer = const T*;
+            using reference = const T&;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            const_iterator(): node_(nullptr), index_(0) {
+
+            }
+
+            const_iterator(BaseNode* node, size_t index): node_(node), index_(index) {
+
+            }
+
+            const_iterator& operator++() {
+                if (++index_ == node_->count) {
+                    node_ = node_->next;
+                    index_ = 0;
+                }
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator res(*this);
+                ++*this;
+                return res;
+            }
+
+            const_iterator& operator--() {
+                if (index_ == 0) {
+                    node_ = node_->prev;
+                    index_ = node_->count;
+                }
+                --index_;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res(*this);
+                --*this;
+                return res;
+            }
+
+            reference operator*() const {
+                return static_cast<Node*>(node_)->items()[index_];
+            }
+
+            pointer operator->() const {
+                return &static_cast<Node*>(node_)->items()[index_];
+            }
+
+            bool operator==(const_iterator other) const  {
+                return node_ == other.node_ and index_ == other.index_;
+            }
+
+            bool operator!=(const_iterator other) const {
+                return !(*this == other);
+            }
+
+        private:
+            friend class unrolled_list;
+            BaseNode* node_;
+            size_t index_;
+        };
+
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+
+        unrolled_list();
+        explicit unrolled_list(const Alloc& alloc);
+        unrolled_list(size_t count, const T& value, const Alloc& alloc = Alloc());
+        explicit unrolled_list(size_t count, const Alloc& alloc = Alloc());
+
+        ~unrolled_list();
+
+        unrolled_list(const unrolled_list& other);
+        unrolled_list(unrolled_list&& other);
+        unrolled_list& operator=(const unrolled_list& other);
+        unrolled_list& operator=(unrolled_list&& other);
+
+        Alloc get_allocator() const;
+
+
+        T& front();
+        const T& front() const;
+
+        T& back();
+        const T& back() const;
+
+
+        iterator begin();
+        iterator end();
+
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+        reverse_iterator rbegin();
+        reverse_iterator rend();
+
+        const_reverse_iterator crbegin() const;
+        const_reverse_iterator crend() const;
+
+
+        bool empty() const;
+        size_t size() const;
+        size_t max_size() const;
+        void clear();
+
+        iterator insert(const_iterator pos, const T& value);
+        iterator insert(const_iterator pos, T&& value);
+        iterator insert(const_iterator pos, size_t count, const T& value);
+
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator first, const_iterator last);
+
+
+        void push_back(const T& value);
+        void push_back(T&& value);
+        void pop_back();
+
+        void push_front(const T& value);
+        void push_front(T&& value);
+        void pop_front();
+
+        template <class... Args>
+        iterator emplace(const_iterator pos, Args&&... args);
+
+        template <class... Args>
+        void emplace_back(Args&&... args);
+
+        template <class... Args>
+        void emplace_front(Args&&... args);
+
+        void resize(size_t count);
+        // Swaps the allocators only if propagate_on_container_swap is set;
+        // otherwise they must compare equal.
+        void swap(unrolled_list& other);
+
+
+        void merge(unrolled_list& other);
+        void splice(const_iterator pos, unrolled_list& other);
+        size_t remove(const T& value);
+        template <class UnaryPredicate>
+        size_t remove_if(UnaryPredicate pred);
+        void reverse();
+        size_t unique();
+        template <class BinaryPredicate>
+        size_t unique(BinaryPredicate pred);
+        void sort();
+        template <class Compare>
+        void sort(Compare comp);
+
+    private:
+
+        void clear_ends(size_t new_size = 0);
+
+        // Exchanges the elements, but not the allocators.
+        void swap_nodes(unrolled_list& other);
+
+        // Appends copies of the elements of `other` in nodes laid out as
+        // its own.
+        void append_copy(const unrolled_list& other);
+
+        Node* create_node();
+        void delete_node(BaseNode* base_node);
+
+        // Links a new empty node right after `node`.
+        Node* insert_node_after(BaseNode* node);
+        // Unlinks and frees an empty node.
+        void unlink_node(BaseNode* node);
+
+        // Moves the elements at [index, count) of `node` into a new node
+        // linked after it.
+        Node* split_node(Node* node, size_t index);
+
+        // Moves the elements of the successor of `node` into it when both
+        // together fill at most half a node; returns whether they merged.
+        bool merge_with_next(Node* node);
+        // Merges underfilled neighbours all along the list after a bulk
+        // removal.
+        void coalesce();
+
+        struct BaseNode {
+            BaseNode(): prev(nullptr), next(nullptr), count(0) {};
+
+            void connect(BaseNode* other) {
+                next = other;
+                other->prev = this;
+            }
+
+            BaseNode* prev;
+            BaseNode* next;
+            size_t count;
+        };
+
+        struct Node: public BaseNode {
+            T* items() {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+
+            // Moves the element at `from` into the uninitialized slot `to`.
+            void relocate(size_t from, T* to) {
+                ::new((void *)to) T(std::move(items()[from]));
+                items()[from].~T();
+            }
+
+            alignas(T) unsigned char storage[Capacity * sizeof(T)];
+        };
+
+        using node_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+        using node_traits = std::allocator_traits<node_allocator>;
+
+        size_t size_;
+        BaseNode head_, tail_;
+        node_allocator node_alloc_;
+    };
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::unrolled_list(): size_(0), head_(), tail_(), node_alloc_() {
+        clear_ends();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::unrolled_list(const Alloc& alloc):
+        size_(0), head_(), tail_(), node_alloc_(alloc) {
+        clear_ends();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::unrolled_list(size_t count, const T& value, const Alloc& alloc):
+        unrolled_list(alloc) {
+        insert(cend(), count, value);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::unrolled_list(size_t count, const Alloc& alloc): unrolled_list(alloc) {
+        resize(count);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::~unrolled_list() {
+        clear();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::unrolled_list(const unrolled_list& other):
+        size_(0), head_(), tail_(), node_alloc_(node_traits::select_on_container_copy_construction(other.node_alloc_)) {
+        clear_ends();
+        append_copy(other);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>::unrolled_list(unrolled_list&& other):
+        size_(0), head_(), tail_(), node_alloc_(std::move(other.node_alloc_)) {
+        clear_ends();
+        if (other.empty()) return;
+
+        size_ = other.size_;
+        head_.connect(other.head_.next);
+        other.tail_.prev->connect(&tail_);
+        other.clear_ends();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>& unrolled_list<T, Capacity, Alloc>::operator=(const unrolled_list& other) {
+        if (this == &other) return *this;
+
+        clear();
+        if constexpr (node_traits::propagate_on_container_copy_assignment::value) {
+            node_alloc_ = other.node_alloc_;
+        }
+        append_copy(other);
+
+        return *this;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    unrolled_list<T, Capacity, Alloc>& unrolled_list<T, Capacity, Alloc>::operator=(unrolled_list&& other) {
+        if (this == &other) return *this;
+
+        clear();
+        if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+            node_alloc_ = std::move(other.node_alloc_);
+            swap_nodes(other);
+        } else if (node_alloc_ == other.node_alloc_) {
+            swap_nodes(other);
+        } else {
+            for (auto& value: other) {
+                emplace_back(std::move(value));
+            }
+        }
+
+        return *this;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    Alloc unrolled_list<T, Capacity, Alloc>::get_allocator() const {
+        return Alloc(node_alloc_);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    T& unrolled_list<T, Capacity, Alloc>::front() {
+        return *begin();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    const T& unrolled_list<T, Capacity, Alloc>::front() const {
+        return *cbegin();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    T& unrolled_list<T, Capacity, Alloc>::back() {
+        return *(--end());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    const T& unrolled_list<T, Capacity, Alloc>::back() const {
+        return *(--cend());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator unrolled_list<T, Capacity, Alloc>::begin() {
+        return {head_.next, 0};
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator unrolled_list<T, Capacity, Alloc>::end() {
+        return {&tail_, 0};
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::const_iterator unrolled_list<T, Capacity, Alloc>::cbegin() const {
+        return {head_.next, 0};
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::const_iterator unrolled_list<T, Capacity, Alloc>::cend() const {
+        return {const_cast<BaseNode*>(&tail_), 0};
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::reverse_iterator unrolled_list<T, Capacity, Alloc>::rbegin() {
+        return reverse_iterator(end());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::reverse_iterator unrolled_list<T, Capacity, Alloc>::rend() {
+        return reverse_iterator(begin());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::const_reverse_iterator
+    unrolled_list<T, Capacity, Alloc>::crbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::const_reverse_iterator
+    unrolled_list<T, Capacity, Alloc>::crend() const {
+        return const_reverse_iterator(cbegin());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    bool unrolled_list<T, Capacity, Alloc>::empty() const {
+        return size_ == 0;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    size_t unrolled_list<T, Capacity, Alloc>::size() const {
+        return size_;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    size_t unrolled_list<T, Capacity, Alloc>::max_size() const {
+        return std::numeric_limits<size_t>::max() / sizeof(T);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::clear() {
+        auto node = head_.next;
+        while (node != &tail_) {
+            auto items = static_cast<Node*>(node)->items();
+            for (size_t i = 0; i < node->count; ++i) {
+                items[i].~T();
+            }
+            node = node->next;
+            delete_node(node->prev);
+        }
+
+        clear_ends();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator
+    unrolled_list<T, Capacity, Alloc>::insert(const_iterator pos, const T& value) {
+        return emplace(pos, value);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator
+    unrolled_list<T, Capacity, Alloc>::insert(const_iterator pos, T&& value) {
+        return emplace(pos, std::move(value));
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator
+    unrolled_list<T, Capacity, Alloc>::insert(const_iterator pos, size_t count, const T& value) {
+        if (count == 0) return {pos.node_, pos.index_};
+
+        // Elements that fit into the free space of the node at `pos` and its
+        // predecessor go there one by one, like single insertions.
+        auto room = pos.node_ == &tail_ ? 0 : Capacity - pos.node_->count;
+        if (pos.index_ == 0 and pos.node_->prev != &head_) {
+            room += Capacity - pos.node_->prev->count;
+        }
+        // `value` may be an element that the insertions below move.
+        T copy(value);
+        if (count <= room) {
+            auto res = emplace(pos, copy);
+            for (auto it = res; --count != 0; ) {
+                it = emplace(std::next(it), copy);
+            }
+            return res;
+        }
+
+        if (pos.index_ != 0) {
+            pos = {split_node(static_cast<Node*>(pos.node_), pos.index_), 0};
+        }
+
+        // Tops up the node in front of `pos`, then fills whole new nodes.
+        auto left = count;
+        auto fill = [&](BaseNode* base) {
+            auto node = static_cast<Node*>(base);
+            for (; left != 0 and node->count < Capacity; --left) {
+                ::new((void *)(node->items() + node->count)) T(copy);
+                ++node->count;
+                ++size_;
+            }
+        };
+
+        auto prev = pos.node_->prev;
+        iterator res(pos.node_, 0);
+        if (prev != &head_ and prev->count < Capacity) {
+            res = {prev, prev->count};
+            fill(prev);
+        }
+
+        while (left != 0) {
+            auto node = insert_node_after(prev);
+            try {
+                fill(node);
+            } catch (...) {
+                if (node->count == 0) unlink_node(node);
+                throw;
+            }
+            if (res.node_ == pos.node_) res = {node, 0};
+            prev = node;
+        }
+
+        return res;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    template <class... Args>
+    typename unrolled_list<T, Capacity, Alloc>::iterator
+    unrolled_list<T, Capacity, Alloc>::emplace(const_iterator pos, Args&&... args) {
+        // Built before any element moves: `args` may refer to one of them.
+        T value(std::forward<Args>(args)...);
+
+        auto base = pos.node_;
+        auto index = pos.index_;
+
+        // The end of a node is a better place than the front of the next one:
+        // appends then fill the last node before allocating.
+        if (index == 0 and base->prev != &head_ and base->prev->count < Capacity) {
+            base = base->prev;
+            index = base->count;
+        } else if (base == &tail_) {
+            base = insert_node_after(tail_.prev);
+        } else if (base->count == Capacity) {
+            if (index == 0) {
+                base = insert_node_after(base->prev);
+            } else {
+                auto half = Capacity / 2;
+                auto upper = split_node(static_cast<Node*>(base), half);
+                if (index > half) {
+                    base = upper;
+                    index -= half;
+                }
+            }
+        }
+
+        auto node = static_cast<Node*>(base);
+        auto items = node->items();
+        try {
+            for (auto i = node->count; i > index; --i) {
+                node->relocate(i - 1, items + i);
+            }
+            ::new((void *)(items + index)) T(std::move(value));
+        } catch (...) {
+            // A node opened for this element must not stay linked empty.
+            if (node->count == 0) unlink_node(node);
+            throw;
+        }
+        ++node->count;
+        ++size_;
+
+        return {node, index};
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator unrolled_list<T, Capacity, Alloc>::erase(const_iterator pos) {
+        auto node = static_cast<Node*>(pos.node_);
+        auto index = pos.index_;
+        auto items = node->items();
+
+        items[index].~T();
+        for (auto i = index + 1; i < node->count; ++i) {
+            node->relocate(i, items + i - 1);
+        }
+        --node->count;
+        --size_;
+
+        if (node->count == 0) {
+            auto next = node->next;
+            unlink_node(node);
+            return {next, 0};
+        }
+
+        merge_with_next(node);
+
+        if (index == node->count) {
+            return {node->next, 0};
+        }
+
+        return {node, index};
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::iterator
+    unrolled_list<T, Capacity, Alloc>::erase(const_iterator first, const_iterator last) {
+        // Erasing moves elements, so `last` is found again by counting.
+        auto count = std::distance(first, last);
+        iterator it(first.node_, first.index_);
+        for (; count != 0; --count) {
+            it = erase(it);
+        }
+
+        return it;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::push_back(const T& value) {
+        emplace(cend(), value);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::push_back(T&& value) {
+        emplace(cend(), std::move(value));
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::pop_back() {
+        erase(--cend());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::push_front(const T& value) {
+        emplace(cbegin(), value);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::push_front(T&& value) {
+        emplace(cbegin(), std::move(value));
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::pop_front() {
+        erase(cbegin());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    template <class... Args>
+    void unrolled_list<T, Capacity, Alloc>::emplace_back(Args&&... args) {
+        emplace(cend(), std::forward<Args>(args)...);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    template <class... Args>
+    void unrolled_list<T, Capacity, Alloc>::emplace_front(Args&&... args) {
+        emplace(cbegin(), std::forward<Args>(args)...);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::resize(size_t count) {
+        while (size_ < count) {
+            emplace(cend());
+        }
+
+        while (size_ > count) {
+            pop_back();
+        }
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::swap(unrolled_list& other) {
+        if constexpr (node_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(node_alloc_, other.node_alloc_);
+        }
+        swap_nodes(other);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::swap_nodes(unrolled_list& other) {
+        std::swap(size_, other.size_);
+
+        if (size_ != 0 || other.size_ != 0) {
+            std::swap(head_, other.head_);
+            std::swap(tail_, other.tail_);
+
+            if (other.size_ == 0) {
+                other.clear_ends();
+            } else {
+                other.head_.connect(other.head_.next);
+                other.tail_.prev->connect(&other.tail_);
+            }
+
+            if (size_ == 0) {
+                clear_ends();
+            } else {
+                head_.connect(head_.next);
+                tail_.prev->connect(&tail_);
+            }
+        }
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::merge(unrolled_list& other) {
+        if (this == &other or other.empty()) return;
+
+        auto it = begin();
+        while (not other.empty()) {
+            while (it != end() and not (other.front() < *it)) {
+                ++it;
+            }
+            if (it == end()) {
+                splice(cend(), other);
+                return;
+            }
+            it = emplace(it, std::move(other.front()));
+            ++it;
+            other.pop_front();
+        }
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::splice(const_iterator pos, unrolled_list& other) {
+        if (this == &other or other.empty()) return;
+
+        auto next = pos.node_;
+        if (pos.index_ != 0) {
+            next = split_node(static_cast<Node*>(pos.node_), pos.index_);
+        }
+
+        auto prev = next->prev;
+        prev->connect(other.head_.next);
+        other.tail_.prev->connect(next);
+        size_ += other.size_;
+
+        other.clear_ends();
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    size_t unrolled_list<T, Capacity, Alloc>::remove(const T& value) {
+        // `value` may refer to an element that is about to be destroyed.
+        T copy(value);
+        return remove_if([&copy](const T& item) { return item == copy; });
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    template <class UnaryPredicate>
+    size_t unrolled_list<T, Capacity, Alloc>::remove_if(UnaryPredicate pred) {
+        // Compacts every node in place, then drops the ones left empty.
+        auto old_size = size_;
+        for (auto base = head_.next; base != &tail_; ) {
+            auto node = static_cast<Node*>(base);
+            auto items = node->items();
+            size_t kept = 0;
+            for (size_t i = 0; i < node->count; ++i) {
+                if (pred(items[i])) {
+                    items[i].~T();
+                } else if (kept++ != i) {
+                    node->relocate(i, items + kept - 1);
+                }
+            }
+            size_ -= node->count - kept;
+            node->count = kept;
+
+            base = base->next;
+            if (kept == 0) {
+                unlink_node(node);
+            }
+        }
+
+        if (size_ != old_size) coalesce();
+        return old_size - size_;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::reverse() {
+        if (size_ < 2) return;
+
+        for (auto node = head_.next; node != &tail_; node = node->prev) {
+            auto items = static_cast<Node*>(node)->items();
+            std::reverse(items, items + node->count);
+            std::swap(node->next, node->prev);
+        }
+
+        auto new_first = tail_.prev;
+        auto new_last = head_.next;
+        head_.connect(new_first);
+        new_last->connect(&tail_);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    size_t unrolled_list<T, Capacity, Alloc>::unique() {
+        return unique(std::equal_to<T>());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    template <class BinaryPredicate>
+    size_t unrolled_list<T, Capacity, Alloc>::unique(BinaryPredicate pred) {
+        if (size_ < 2) return 0;
+
+        auto old_size = size_;
+        const T* last_kept = nullptr;
+        for (auto base = head_.next; base != &tail_; ) {
+            auto node = static_cast<Node*>(base);
+            auto items = node->items();
+            size_t kept = 0;
+            for (size_t i = 0; i < node->count; ++i) {
+                if (last_kept and pred(*last_kept, items[i])) {
+                    items[i].~T();
+                    continue;
+                }
+                if (kept != i) {
+                    node->relocate(i, items + kept);
+                }
+                last_kept = items + kept++;
+            }
+            size_ -= node->count - kept;
+            node->count = kept;
+
+            base = base->next;
+            if (kept == 0) {
+                unlink_node(node);
+            }
+        }
+
+        if (size_ != old_size) coalesce();
+        return old_size - size_;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::sort() {
+        sort(std::less<T>());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    template <class Compare>
+    void unrolled_list<T, Capacity, Alloc>::sort(Compare comp) {
+        if (size_ < 2) return;
+
+        // Elements already live in arrays, so sorting a contiguous copy and
+        // moving the values back beats relinking.
+        std::vector<T> values;
+        values.reserve(size_);
+        std::move(begin(), end(), std::back_inserter(values));
+        std::stable_sort(values.begin(), values.end(), comp);
+        std::move(values.begin(), values.end(), begin());
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::clear_ends(size_t new_size) {
+        tail_.prev = &head_;
+        head_.next = &tail_;
+        size_ = new_size;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::Node* unrolled_list<T, Capacity, Alloc>::create_node() {
+        Node* node = node_traits::allocate(node_alloc_, 1);
+        ::new((void *)node) Node();
+        return node;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::delete_node(BaseNode* base_node) {
+        auto node = static_cast<Node*>(base_node);
+        node->~Node();
+        node_traits::deallocate(node_alloc_, node, 1);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::Node*
+    unrolled_list<T, Capacity, Alloc>::insert_node_after(BaseNode* node) {
+        auto res = create_node();
+        auto next = node->next;
+        node->connect(res);
+        res->connect(next);
+        return res;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::unlink_node(BaseNode* node) {
+        node->prev->connect(node->next);
+        delete_node(node);
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    typename unrolled_list<T, Capacity, Alloc>::Node*
+    unrolled_list<T, Capacity, Alloc>::split_node(Node* node, size_t index) {
+        auto upper = insert_node_after(node);
+        for (auto i = index; i < node->count; ++i) {
+            node->relocate(i, upper->items() + i - index);
+        }
+        upper->count = node->count - index;
+        node->count = index;
+        return upper;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    bool unrolled_list<T, Capacity, Alloc>::merge_with_next(Node* node) {
+        auto next = node->next;
+        if (next == &tail_ or node->count + next->count > Capacity / 2) return false;
+
+        auto source = static_cast<Node*>(next);
+        for (size_t i = 0; i < source->count; ++i) {
+            source->relocate(i, node->items() + node->count + i);
+        }
+        node->count += source->count;
+        source->count = 0;
+        unlink_node(source);
+        return true;
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::coalesce() {
+        for (auto base = head_.next; base != &tail_; base = base->next) {
+            while (merge_with_next(static_cast<Node*>(base))) {}
+        }
+    }
+
+    template<class T, size_t Capacity, class Alloc>
+    void unrolled_list<T, Capacity, Alloc>::append_copy(const unrolled_list& other) {
+        for (auto node = other.head_.next; node != &other.tail_; node = node->next) {
+            auto source = static_cast<Node*>(node);
+            auto copy = insert_node_after(tail_.prev);
+            try {
+                for (size_t i = 0; i < source->count; ++i) {
+                    ::new((void *)(copy->items() + i)) T(source->items()[i]);
+                    ++copy->count;
+                    ++size_;
+                }
+            } catch (...) {
+                if (copy->count == 0) unlink_node(copy);
+                throw;
+            }
+        }
+    }
+
+}  // namespace task
@@ -4,7 +4,16 @@
 #include <algorithm>
 #include <vector>
 #include <list>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
 #include "task/list.h"
+#include "task/unrolled_list.h"
+#include "task/concurrent_queue.h"
+#include "task/intrusive_list.h"
 
 
 size_t RandomUInt(size_t max = -1) {
@@ -48,6 +57,135 @@ void FailWithMsg(const std::string& msg, int line) {
     ASSERT_TRUE_MSG(std::equal(cont1.begin(), cont1.end(), cont2.begin(), cont2.end()), msg)
 
 
+struct ReadyTag {};
+struct AllTag {};
+
+struct Job: task::list_hook<ReadyTag>, task::list_hook<AllTag> {
+    explicit Job(size_t id): id(id) {
+
+    }
+
+    size_t id;
+};
+
+
+// Stateful allocator over a counting arena; allocators compare equal when
+// they share the arena and nothing propagates between containers.
+struct Arena {
+    size_t allocated = 0;
+    size_t live = 0;
+};
+
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena): arena(std::move(arena)) {
+
+    }
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other): arena(other.arena) {
+
+    }
+
+    T* allocate(size_t n) {
+        arena->allocated += n;
+        arena->live += n;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        arena->live -= n;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+
+    std::shared_ptr<Arena> arena;
+};
+
+
+// Allocator handing out consecutive blocks of one buffer and never reusing
+// them, so addresses follow the order of allocation on any platform.
+struct BumpArena {
+    explicit BumpArena(size_t bytes): storage(bytes / sizeof(std::max_align_t) + 1) {
+
+    }
+
+    std::vector<std::max_align_t> storage;
+    size_t used = 0;
+};
+
+template <class T>
+struct BumpAllocator {
+    using value_type = T;
+
+    explicit BumpAllocator(std::shared_ptr<BumpArena> arena): arena(std::move(arena)) {
+
+    }
+
+    template <class U>
+    BumpAllocator(const BumpAllocator<U>& other): arena(other.arena) {
+
+    }
+
+    T* allocate(size_t n) {
+        auto offset = (arena->used + alignof(T) - 1) / alignof(T) * alignof(T);
+        if (offset + n * sizeof(T) > arena->storage.size() * sizeof(std::max_align_t)) throw std::bad_alloc();
+        arena->used = offset + n * sizeof(T);
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(arena->storage.data()) + offset);
+    }
+
+    void deallocate(T*, size_t) {
+
+    }
+
+    template <class U>
+    bool operator==(const BumpAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    template <class U>
+    bool operator!=(const BumpAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+
+    std::shared_ptr<BumpArena> arena;
+};
+
+
+// Element whose constructors throw once `budget` more of them have run; a
+// negative budget never runs out.
+struct Fragile {
+    explicit Fragile(int value): value(value) {
+        spend();
+    }
+
+    Fragile(const Fragile& other): value(other.value) {
+        spend();
+    }
+
+    Fragile& operator=(const Fragile& other) = default;
+
+    static void spend() {
+        if (budget == 0) throw std::runtime_error("Fragile");
+        --budget;
+    }
+
+    static inline int budget = -1;
+    int value;
+};
+
+
 int main() {
 
     {
@@ -246,4 +384,933 @@ int main() {
         }
     }
 
+    {
+        using PoolList = task::list<size_t, task::PoolAllocator<size_t>>;
+        task::PoolAllocator<size_t> alloc;
+
+        PoolList list_task(alloc);
+        std::list<size_t> list_std;
+
+        list_task.insert(list_task.cend(), 1000, 7);
+        list_std.insert(list_std.end(), 1000, 7);
+        RandomFill(list_task, 500);
+        std::copy(std::next(list_task.begin(), 1000), list_task.end(), std::back_inserter(list_std));
+        ASSERT_EQUAL_MSG(list_task, list_std, "Pool list::insert")
+
+        PoolList list_task2 = list_task;
+        ASSERT_TRUE(list_task2.get_allocator() == alloc)
+        ASSERT_EQUAL_MSG(list_task2, list_std, "Pool copy constructor")
+
+        list_task.sort();
+        list_std.sort();
+        ASSERT_EQUAL_MSG(list_task, list_std, "Pool list::sort")
+
+        // Released nodes are recycled, so churn does not grow the pool.
+        auto slabs = alloc.pool()->slab_count();
+        for (size_t iter = 0; iter < 100; ++iter) {
+            list_task2.resize(0);
+            list_task2.resize(1500);
+            for (size_t i = 0; i < 100; ++i) {
+                list_task2.push_back(i);
+                list_task2.pop_front();
+            }
+        }
+        ASSERT_TRUE(alloc.pool()->slab_count() == slabs)
+        ASSERT_TRUE(list_task2.size() == 1500)
+    }
+
+    {
+        task::NodePool pool;
+        // Blocks smaller than a pointer are rounded up and recycled.
+        auto small = pool.allocate(4, 4);
+        pool.deallocate(small, 4, 4);
+        ASSERT_TRUE_MSG(pool.allocate(4, 4) == small, "NodePool recycles small blocks")
+
+        // A run carved at 8 bytes past a 16-byte boundary; its blocks are
+        // not handed to a type of the same size that needs 16.
+        auto run = pool.allocate(16, 8, 2);
+        pool.deallocate(run, 16, 8, 2);
+        ASSERT_TRUE(reinterpret_cast<std::uintptr_t>(run) % 16 == 8 and pool.has_recycled(16, 8))
+        auto strict = pool.allocate(16, 16);
+        ASSERT_TRUE_MSG(reinterpret_cast<std::uintptr_t>(strict) % 16 == 0, "NodePool keeps alignments apart")
+        ASSERT_TRUE(pool.allocate(16, 8) != strict)
+    }
+
+    {
+        task::unrolled_list<size_t, 4> list_task;
+        std::list<size_t> list_std;
+
+        for (size_t iter = 0; iter < 4000; ++iter) {
+            auto pos = RandomUInt(list_std.size());
+            auto it_task = std::next(list_task.begin(), pos);
+            auto it_std = std::next(list_std.begin(), pos);
+            auto val = RandomUInt(20);
+
+            switch (RandomUInt(5)) {
+                case 0:
+                case 1:
+                    ASSERT_TRUE(*list_task.insert(it_task, val) == val)
+                    list_std.insert(it_std, val);
+                    break;
+                case 2:
+                    list_task.insert(it_task, 3, val);
+                    list_std.insert(it_std, 3, val);
+                    break;
+                case 3:
+                    if (it_std != list_std.end()) {
+                        auto next_task = list_task.erase(it_task);
+                        auto next_std = list_std.erase(it_std);
+                        ASSERT_TRUE(std::distance(list_task.begin(), next_task) ==
+                                    std::distance(list_std.begin(), next_std))
+                    }
+                    break;
+                case 4:
+                    list_task.push_front(val);
+                    list_std.push_front(val);
+                    list_task.pop_back();
+                    list_std.pop_back();
+                    break;
+                case 5:
+                    list_task.erase(list_task.begin(), it_task);
+                    list_std.erase(list_std.begin(), it_std);
+                    break;
+            }
+
+            ASSERT_TRUE(list_task.size() == list_std.size())
+        }
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::insert / erase")
+
+        task::unrolled_list<size_t, 4> list_task2(list_task);
+        std::list<size_t> list_std2(list_std);
+
+        auto removed = list_task.remove(list_task.front());
+        auto old_size = list_std.size();
+        list_std.remove(list_std.front());
+        ASSERT_TRUE(removed == old_size - list_std.size())
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::remove")
+
+        list_task.reverse();
+        list_std.reverse();
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::reverse")
+
+        list_task.sort();
+        list_std.sort();
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::sort")
+
+        list_task.unique();
+        list_std.unique();
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::unique")
+
+        list_task.splice(std::next(list_task.begin(), list_task.size() / 2), list_task2);
+        list_std.splice(std::next(list_std.begin(), list_std.size() / 2), list_std2);
+        ASSERT_TRUE(list_task2.empty())
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::splice")
+
+        std::vector<size_t> reversed_task(list_task.rbegin(), list_task.rend());
+        std::vector<size_t> reversed_std(list_std.rbegin(), list_std.rend());
+        ASSERT_EQUAL_MSG(reversed_task, reversed_std, "Unrolled list reverse iterator")
+
+        task::unrolled_list<std::string> strings(10, "test");
+        strings.resize(3);
+        strings.emplace_back(5, 'a');
+        ASSERT_TRUE(strings.size() == 4 and strings.back() == "aaaaa" and strings.front() == "test")
+    }
+
+    {
+        // Bulk removals merge the nodes they leave underfilled.
+        using ArenaUnrolled = task::unrolled_list<size_t, 8, ArenaAllocator<size_t>>;
+        auto arena = std::make_shared<Arena>();
+        ArenaAllocator<size_t> alloc(arena);
+
+        ArenaUnrolled list_task(alloc);
+        std::vector<size_t> kept;
+        for (size_t i = 0; i < 8000; ++i) {
+            list_task.push_back(i);
+            if (i % 8 == 0) kept.push_back(i);
+        }
+        ASSERT_TRUE(list_task.remove_if([](size_t value) { return value % 8 != 0; }) == 7000)
+        ASSERT_EQUAL_MSG(list_task, kept, "Unrolled list::remove_if")
+        ASSERT_TRUE_MSG(arena->live <= list_task.size() / 2, "Unrolled list::remove_if merges nodes")
+
+        ArenaUnrolled runs(alloc);
+        for (size_t i = 0; i < 8000; ++i) {
+            runs.push_back(i / 8);
+        }
+        ASSERT_TRUE(runs.unique() == 7000 and runs.size() == 1000 and runs.back() == 999)
+        ASSERT_TRUE_MSG(arena->live <= (list_task.size() + runs.size()) / 2, "Unrolled list::unique merges nodes")
+
+        ArenaUnrolled copy(list_task);
+        copy.swap(runs);
+        ASSERT_TRUE(copy.get_allocator() == alloc and copy.size() == 1000 and copy.back() == 999)
+        ASSERT_EQUAL_MSG(runs, kept, "Unrolled list copy and swap within an arena")
+    }
+
+    {
+        // An inserted element is built before its node is split or opened.
+        task::unrolled_list<std::string, 4> strings;
+        for (auto value: {"a", "b", "c", "d"}) {
+            strings.push_back(value);
+        }
+        strings.insert(std::next(strings.cbegin()), strings.back());
+        std::vector<std::string> expected{"a", "d", "b", "c", "d"};
+        ASSERT_EQUAL_MSG(strings, expected, "Unrolled list::insert of its own element")
+
+        auto arena = std::make_shared<Arena>();
+        task::unrolled_list<std::string, 4, ArenaAllocator<std::string>> full(ArenaAllocator<std::string>{arena});
+        full.insert(full.cend(), 4, "x");
+        auto live = arena->live;
+        for (size_t index: {0, 2, 4}) {
+            bool thrown = false;
+            try {
+                full.emplace(std::next(full.cbegin(), index), std::string().max_size() + 1, 'a');
+            } catch (const std::length_error&) {
+                thrown = true;
+            }
+            ASSERT_TRUE_MSG(thrown and arena->live == live, "Unrolled list::emplace throws")
+            ASSERT_TRUE(static_cast<size_t>(std::distance(full.begin(), full.end())) == full.size())
+        }
+        ASSERT_TRUE(full.size() == 4)
+
+        // Small repeated insertions fill the free space around the position.
+        using ArenaUnrolled = task::unrolled_list<size_t, 8, ArenaAllocator<size_t>>;
+        ArenaUnrolled list_task{ArenaAllocator<size_t>(arena)};
+        std::vector<size_t> list_std;
+        for (size_t i = 0; i < 300; ++i) {
+            auto index = RandomUInt(list_std.size());
+            auto count = RandomUInt(1, 3);
+            auto it = list_task.insert(std::next(list_task.cbegin(), index), count, i);
+            list_std.insert(list_std.begin() + index, count, i);
+            ASSERT_TRUE(*it == i and static_cast<size_t>(std::distance(list_task.begin(), it)) == index)
+        }
+        ASSERT_EQUAL_MSG(list_task, list_std, "Unrolled list::insert of copies")
+        ASSERT_TRUE_MSG(arena->live - live <= list_std.size() / 4, "Unrolled list::insert of copies fills nodes")
+    }
+
+    {
+        task::list<size_t> list_task;
+        std::list<size_t> list_std;
+        RandomFill(list_std, 1000, 100);
+        for (auto value: list_std) {
+            list_task.push_back(value);
+        }
+
+        task::list<size_t> other_task;
+        std::list<size_t> other_std;
+
+        for (size_t iter = 0; iter < 2000; ++iter) {
+            auto pos = RandomUInt(list_std.size());
+            auto it_task = std::next(list_task.begin(), pos);
+            auto it_std = std::next(list_std.begin(), pos);
+
+            switch (RandomUInt(3)) {
+                case 0:
+                    // Move to front, as an LRU cache does on a hit.
+                    if (it_std != list_std.end()) {
+                        list_task.splice(list_task.begin(), list_task, it_task);
+                        list_std.splice(list_std.begin(), list_std, it_std);
+                    }
+                    break;
+                case 1: {
+                    auto count = RandomUInt(list_std.size() - pos);
+                    auto dest = RandomUInt(other_std.size());
+                    other_task.splice(std::next(other_task.begin(), dest), list_task,
+                                      it_task, std::next(it_task, count));
+                    other_std.splice(std::next(other_std.begin(), dest), list_std,
+                                     it_std, std::next(it_std, count));
+                    break;
+                }
+                case 2:
+                    if (not other_std.empty()) {
+                        list_task.splice(it_task, other_task, other_task.begin());
+                        list_std.splice(it_std, other_std, other_std.begin());
+                    }
+                    break;
+                case 3: {
+                    // A range moved to the end of its own list.
+                    auto count = RandomUInt(list_std.size() - pos);
+                    list_task.splice(list_task.end(), list_task, it_task, std::next(it_task, count));
+                    list_std.splice(list_std.end(), list_std, it_std, std::next(it_std, count));
+                    break;
+                }
+            }
+
+            ASSERT_TRUE(list_task.size() == list_std.size() and other_task.size() == other_std.size())
+        }
+
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::splice of elements and ranges")
+        ASSERT_EQUAL_MSG(other_task, other_std, "list::splice of elements and ranges")
+    }
+
+    {
+        // Sorting by key only must keep equal keys in insertion order.
+        using Item = std::pair<size_t, size_t>;
+        auto by_key = [](const Item& left, const Item& right) { return left.first < right.first; };
+
+        task::list<Item> list_task;
+        std::vector<Item> items;
+        for (size_t i = 0, count = RandomUInt(1000, 5000); i < count; ++i) {
+            items.emplace_back(RandomUInt(50), i);
+            list_task.push_back(items.back());
+        }
+
+        list_task.sort(by_key);
+        std::stable_sort(items.begin(), items.end(), by_key);
+        ASSERT_EQUAL_MSG(list_task, items, "list::sort stability")
+
+        std::vector<Item> reversed(list_task.rbegin(), list_task.rend());
+        std::reverse(items.begin(), items.end());
+        ASSERT_EQUAL_MSG(reversed, items, "list::sort relinks prev pointers")
+
+        list_task.sort([](const Item& left, const Item& right) { return left.second > right.second; });
+        ASSERT_TRUE(list_task.front().second == items.size() - 1 and list_task.back().second == 0)
+    }
+
+    {
+        using Item = std::pair<size_t, size_t>;
+        auto by_key = [](const Item& left, const Item& right) { return left.first < right.first; };
+
+        task::list<Item> list_task;
+        std::vector<Item> items;
+        for (size_t i = 0; i < 200000; ++i) {
+            items.emplace_back(RandomUInt(1000), i);
+            list_task.push_back(items.back());
+        }
+
+        task::thread_pool pool(3);
+        list_task.parallel_sort(by_key, pool);
+        std::stable_sort(items.begin(), items.end(), by_key);
+        ASSERT_EQUAL_MSG(list_task, items, "list::parallel_sort")
+
+        std::vector<Item> reversed(list_task.rbegin(), list_task.rend());
+        std::reverse(items.begin(), items.end());
+        ASSERT_EQUAL_MSG(reversed, items, "list::parallel_sort relinks prev pointers")
+
+        task::list<Item> other_task;
+        std::list<Item> list_std(list_task.cbegin(), list_task.cend());
+        std::list<Item> other_std;
+        for (size_t i = 0; i < 1000; ++i) {
+            other_task.emplace_back(RandomUInt(1000), i);
+            other_std.push_back(other_task.back());
+        }
+        other_task.sort(by_key);
+        other_std.sort(by_key);
+
+        list_task.merge(other_task, by_key);
+        list_std.merge(other_std, by_key);
+        ASSERT_TRUE(other_task.empty() and list_task.size() == list_std.size())
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::merge with comparator")
+    }
+
+    {
+        // A throwing comparison leaves every element linked in the list.
+        std::vector<size_t> values;
+        RandomFill(values, 100000, 1000);
+        auto sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+
+        std::atomic<size_t> comparisons(0);
+        size_t limit = 0;
+        auto fragile_less = [&](size_t lhs, size_t rhs) {
+            if (++comparisons == limit) throw std::runtime_error("comparison");
+            return lhs < rhs;
+        };
+        auto holds_all = [&](const task::list<size_t>& list) {
+            std::vector<size_t> items(list.cbegin(), list.cend());
+            std::vector<size_t> reversed(list.crbegin(), list.crend());
+            std::sort(items.begin(), items.end());
+            std::sort(reversed.begin(), reversed.end());
+            return list.size() == sorted.size() and items == sorted and reversed == sorted;
+        };
+
+        task::thread_pool pool(3);
+        for (size_t step: {size_t(1), size_t(1000), size_t(40000), SIZE_MAX}) {
+            for (size_t op = 0; op < 3; ++op) {
+                task::list<size_t> list_task(values.begin(), values.begin() + values.size() / 2);
+                task::list<size_t> other(values.begin() + values.size() / 2, values.end());
+                bool thrown = false;
+                comparisons = 0;
+                limit = step;
+                try {
+                    if (op == 0) {
+                        list_task.splice(list_task.cend(), other);
+                        list_task.sort(fragile_less);
+                    } else if (op == 1) {
+                        list_task.splice(list_task.cend(), other);
+                        list_task.parallel_sort(fragile_less, pool);
+                    } else {
+                        limit = 0;
+                        list_task.sort();
+                        other.sort();
+                        comparisons = 0;
+                        limit = step;
+                        list_task.merge(other, fragile_less);
+                    }
+                } catch (const std::runtime_error&) {
+                    thrown = true;
+                }
+                ASSERT_TRUE_MSG(thrown == (step != SIZE_MAX), "list::sort / merge with a throwing comparison")
+                ASSERT_TRUE_MSG(other.empty() and holds_all(list_task), "list::sort / merge with a throwing comparison")
+                ASSERT_TRUE(thrown or std::is_sorted(list_task.begin(), list_task.end()))
+            }
+        }
+    }
+
+    {
+        // A throwing element constructor frees every node built so far.
+        auto arena = std::make_shared<Arena>();
+        ArenaAllocator<Fragile> alloc(arena);
+        using FragileList = task::list<Fragile, ArenaAllocator<Fragile>>;
+
+        std::vector<Fragile> source;
+        std::string numbers;
+        for (int i = 0; i < 100; ++i) {
+            source.emplace_back(i);
+            numbers += std::to_string(i) + " ";
+        }
+        FragileList list_task(source.begin(), source.begin() + 10, alloc);
+        auto live = arena->live;
+        size_t size = 10;
+
+        auto throws = [&](auto op) {
+            Fragile::budget = 50;
+            bool thrown = false;
+            try {
+                op();
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            Fragile::budget = -1;
+            return thrown and arena->live == live and list_task.size() == size;
+        };
+        ASSERT_TRUE_MSG(throws([&] { list_task.insert(list_task.cend(), source.begin(), source.end()); }),
+                        "list::insert of a forward range throws")
+        ASSERT_TRUE_MSG(throws([&] {
+            std::istringstream input(numbers);
+            list_task.insert(list_task.cend(), std::istream_iterator<int>(input), std::istream_iterator<int>());
+        }), "list::insert of an input range throws")
+        ASSERT_TRUE_MSG(throws([&] { list_task.insert(list_task.cend(), 100, source.front()); }),
+                        "list::insert of copies throws")
+        ASSERT_TRUE_MSG(throws([&] { list_task.assign(source.begin(), source.end()); }), "list::assign throws")
+        ASSERT_TRUE_MSG(throws([&] { FragileList other(source.begin(), source.end(), alloc); }),
+                        "list range constructor throws")
+
+        list_task.assign(source.begin(), source.end());
+        live = arena->live;
+        size = source.size();
+        ASSERT_TRUE_MSG(throws([&] { FragileList copy(list_task); }), "list copy constructor throws")
+    }
+
+    {
+        // The rest of a bulk run goes back to the pool when a constructor throws.
+        Fragile value(0);
+        task::list<Fragile, task::PoolAllocator<Fragile>> probe;
+        probe.insert(probe.cend(), 2, value);
+        auto node_size = reinterpret_cast<char*>(&probe.back()) - reinterpret_cast<char*>(&probe.front());
+
+        // One slab holds exactly one run of 100 nodes.
+        task::PoolAllocator<Fragile> alloc(std::make_shared<task::NodePool>(100 * node_size));
+        task::list<Fragile, task::PoolAllocator<Fragile>> list_task(alloc);
+        Fragile::budget = 50;
+        try {
+            list_task.insert(list_task.cend(), 100, value);
+        } catch (const std::runtime_error&) {
+        }
+        Fragile::budget = -1;
+        ASSERT_TRUE(list_task.empty() and alloc.pool()->slab_count() == 1)
+        list_task.insert(list_task.cend(), 100, value);
+        ASSERT_TRUE_MSG(alloc.pool()->slab_count() == 1, "Pool list reuses runs after a throw")
+    }
+
+    {
+        const size_t PRODUCERS = 4;
+        const size_t CONSUMERS = 4;
+        const size_t ITEMS = 20000;
+
+        task::concurrent_queue<std::pair<size_t, size_t>> queue;
+        std::vector<std::vector<std::pair<size_t, size_t>>> received(CONSUMERS);
+        std::atomic<size_t> popped(0);
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < PRODUCERS; ++p) {
+            threads.emplace_back([&, p] {
+                for (size_t i = 0; i < ITEMS; ++i) {
+                    queue.push_back({p, i});
+                }
+            });
+        }
+        for (size_t c = 0; c < CONSUMERS; ++c) {
+            threads.emplace_back([&, c] {
+                std::pair<size_t, size_t> item;
+                while (popped < PRODUCERS * ITEMS) {
+                    if (queue.pop_front(item)) {
+                        received[c].push_back(item);
+                        ++popped;
+                    }
+                }
+            });
+        }
+        for (auto& thread: threads) {
+            thread.join();
+        }
+
+        ASSERT_TRUE(queue.empty())
+
+        // Every item arrives once, and each consumer sees the items of one
+        // producer in the order they were pushed.
+        std::vector<size_t> counts(PRODUCERS);
+        for (const auto& items: received) {
+            std::vector<size_t> last(PRODUCERS, 0);
+            for (const auto& item: items) {
+                ASSERT_TRUE_MSG(last[item.first] <= item.second, "concurrent_queue FIFO order")
+                last[item.first] = item.second;
+                ++counts[item.first];
+            }
+        }
+        for (auto count: counts) {
+            ASSERT_TRUE_MSG(count == ITEMS, "concurrent_queue lost or duplicated items")
+        }
+
+        task::concurrent_queue<std::string> strings;
+        strings.emplace_back(3, 'a');
+        strings.push_back("b");
+        std::string value;
+        ASSERT_TRUE(strings.pop_front(value) and value == "aaa")
+        ASSERT_TRUE(not strings.empty())
+
+        // A throwing element constructor leaves no node behind.
+        auto arena = std::make_shared<Arena>();
+        {
+            task::concurrent_queue<std::string, ArenaAllocator<std::string>> queue(ArenaAllocator<std::string>{arena});
+            auto live = arena->live;
+            bool thrown = false;
+            try {
+                queue.emplace_back(std::string().max_size() + 1, 'a');
+            } catch (const std::length_error&) {
+                thrown = true;
+            }
+            ASSERT_TRUE_MSG(thrown and arena->live == live and queue.empty(), "concurrent_queue::emplace_back throws")
+        }
+        ASSERT_TRUE(arena->live == 0)
+    }
+
+    {
+        std::vector<Job> jobs;
+        for (size_t i = 0; i < 100; ++i) {
+            jobs.emplace_back(i);
+        }
+
+        task::intrusive_list<Job, AllTag> all;
+        task::intrusive_list<Job, ReadyTag> ready;
+        task::intrusive_list<Job, ReadyTag> waiting;
+        std::list<size_t> ready_std;
+        std::list<size_t> waiting_std;
+
+        for (auto& job: jobs) {
+            all.push_back(job);
+            if (job.id % 3 == 0) {
+                ready.push_front(job);
+                ready_std.push_front(job.id);
+            } else {
+                waiting.push_back(job);
+                waiting_std.push_back(job.id);
+            }
+        }
+
+        auto ids = [](const auto& list) {
+            std::vector<size_t> res;
+            for (auto it = list.cbegin(); it != list.cend(); ++it) {
+                res.push_back(it->id);
+            }
+            return res;
+        };
+
+        // Waking a job moves it between lists without touching the others.
+        for (size_t iter = 0; iter < 200; ++iter) {
+            auto& job = jobs[RandomUInt(jobs.size() - 1)];
+            if (static_cast<task::list_hook<ReadyTag>&>(job).is_linked()) {
+                auto in_ready = std::find(ready_std.begin(), ready_std.end(), job.id);
+                if (in_ready != ready_std.end()) {
+                    waiting.splice(waiting.cend(), ready, ready.iterator_to(job));
+                    waiting_std.splice(waiting_std.end(), ready_std, in_ready);
+                } else {
+                    auto in_waiting = std::find(waiting_std.begin(), waiting_std.end(), job.id);
+                    ready.splice(ready.cbegin(), waiting, waiting.iterator_to(job));
+                    ready_std.splice(ready_std.begin(), waiting_std, in_waiting);
+                }
+            }
+        }
+
+        auto ready_ids = ids(ready);
+        auto waiting_ids = ids(waiting);
+        ASSERT_EQUAL_MSG(ready_ids, ready_std, "intrusive_list::splice")
+        ASSERT_EQUAL_MSG(waiting_ids, waiting_std, "intrusive_list::splice")
+        ASSERT_TRUE(ready.size() + waiting.size() == jobs.size() and all.size() == jobs.size())
+
+        all.erase(jobs[5]);
+        all.pop_front();
+        ASSERT_TRUE(all.size() == jobs.size() - 2 and all.front().id == 1)
+        ASSERT_TRUE(not static_cast<task::list_hook<AllTag>&>(jobs[5]).is_linked())
+        ASSERT_TRUE(static_cast<task::list_hook<ReadyTag>&>(jobs[5]).is_linked())
+
+        all.reverse();
+        ASSERT_TRUE(all.front().id == jobs.size() - 1 and all.back().id == 1)
+
+        task::intrusive_list<Job, ReadyTag> moved(std::move(ready));
+        ASSERT_TRUE(ready.empty())
+        auto moved_ids = ids(moved);
+        ASSERT_EQUAL_MSG(moved_ids, ready_std, "intrusive_list move constructor")
+
+        moved.swap(waiting);
+        auto swapped_ids = ids(moved);
+        ASSERT_EQUAL_MSG(swapped_ids, waiting_std, "intrusive_list::swap")
+    }
+
+    {
+        task::list<size_t, task::PoolAllocator<size_t>> list_task;
+        std::list<size_t> list_std;
+        RandomFill(list_std, RandomUInt(1000, 5000), 20);
+        for (auto value: list_std) {
+            list_task.push_back(value);
+        }
+
+        auto is_odd = [](size_t value) { return value % 2 == 1; };
+        auto old_size = list_std.size();
+        list_std.remove_if(is_odd);
+        ASSERT_TRUE(list_task.remove_if(is_odd) == old_size - list_std.size())
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::remove_if")
+
+        auto same_tens = [](size_t left, size_t right) { return left / 10 == right / 10; };
+        old_size = list_std.size();
+        list_std.unique(same_tens);
+        ASSERT_TRUE(list_task.unique(same_tens) == old_size - list_std.size())
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::unique with predicate")
+
+        // Removed nodes went back to the pool and are reused.
+        auto slabs = list_task.get_allocator().pool()->slab_count();
+        list_task.insert(list_task.cend(), old_size - list_std.size(), 0);
+        ASSERT_TRUE(list_task.get_allocator().pool()->slab_count() == slabs)
+
+        list_std.insert(list_std.end(), old_size - list_std.size(), 0);
+        old_size = list_std.size();
+        list_std.remove(list_std.back());
+        ASSERT_TRUE_MSG(list_task.remove(list_task.back()) == old_size - list_std.size(), "list::remove count")
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::remove")
+
+        list_std.sort();
+        list_task.sort();
+        old_size = list_std.size();
+        list_std.unique();
+        ASSERT_TRUE_MSG(old_size != list_std.size(), "list::unique test needs duplicates")
+        ASSERT_TRUE_MSG(list_task.unique() == old_size - list_std.size(), "list::unique count")
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::unique")
+
+        // Values are at most 20, and duplicates are gone.
+        ASSERT_TRUE(list_task.remove(21) == 0 and list_task.unique() == 0)
+    }
+
+    {
+        std::vector<size_t> values;
+        RandomFill(values, RandomUInt(100, 1000));
+
+        task::list<size_t> list_task(values.begin(), values.end());
+        ASSERT_EQUAL_MSG(list_task, values, "Range constructor")
+
+        std::istringstream input("1 2 3 4 5");
+        task::list<int> from_input{std::istream_iterator<int>(input), std::istream_iterator<int>()};
+        std::vector<int> expected = {1, 2, 3, 4, 5};
+        ASSERT_EQUAL_MSG(from_input, expected, "Range constructor from input iterators")
+
+        // Assigning a range of the same length reuses every node.
+        auto front = &list_task.front();
+        std::reverse(values.begin(), values.end());
+        list_task.assign(values.begin(), values.end());
+        ASSERT_TRUE(&list_task.front() == front)
+        ASSERT_EQUAL_MSG(list_task, values, "list::assign")
+
+        values.resize(values.size() / 2);
+        list_task.assign(values.begin(), values.end());
+        ASSERT_TRUE(&list_task.front() == front and list_task.size() == values.size())
+        ASSERT_EQUAL_MSG(list_task, values, "list::assign of a shorter range")
+
+        list_task.assign(values.size() + 10, 7);
+        std::vector<size_t> sevens(values.size() + 10, 7);
+        ASSERT_TRUE(&list_task.front() == front)
+        ASSERT_EQUAL_MSG(list_task, sevens, "list::assign(count, value)")
+
+        task::list<size_t> list_task2(3, 1);
+        list_task2 = list_task;
+        ASSERT_EQUAL_MSG(list_task2, list_task, "Copy assignment")
+
+        std::list<size_t> list_std(list_task.cbegin(), list_task.cend());
+        auto inserted = list_task.insert(std::next(list_task.begin(), 5), values.begin(), values.end());
+        list_std.insert(std::next(list_std.begin(), 5), values.begin(), values.end());
+        ASSERT_TRUE(inserted == std::next(list_task.begin(), 5))
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::insert of a range")
+
+        ASSERT_TRUE(list_task.insert(list_task.begin(), values.end(), values.end()) == list_task.begin())
+        ASSERT_TRUE(list_task.insert(list_task.end(), 0, 1) == list_task.end())
+    }
+
+    {
+        // Interleaved inserts at random positions scatter the nodes.
+        task::list<size_t, task::PoolAllocator<size_t>> list_task;
+        std::list<size_t> list_std;
+        for (size_t i = 0; i < 3000; ++i) {
+            auto pos = RandomUInt(list_std.size());
+            list_task.insert(std::next(list_task.begin(), pos), i);
+            list_std.insert(std::next(list_std.begin(), pos), i);
+            if (TossCoin()) {
+                list_task.push_front(i);
+                list_task.pop_front();
+            }
+        }
+
+        auto contiguous = [](auto& list) {
+            auto first = reinterpret_cast<const char*>(&*list.cbegin());
+            auto stride = reinterpret_cast<const char*>(&*std::next(list.cbegin())) - first;
+            size_t i = 0;
+            for (auto& value: list) {
+                if (reinterpret_cast<const char*>(&value) != first + stride * i++) return false;
+            }
+            return stride > 0;
+        };
+
+        ASSERT_TRUE(not contiguous(list_task))
+        list_task.compact();
+        ASSERT_TRUE(contiguous(list_task))
+        ASSERT_EQUAL_MSG(list_task, list_std, "list::compact")
+
+        std::vector<size_t> reversed(list_task.rbegin(), list_task.rend());
+        std::vector<size_t> reversed_std(list_std.rbegin(), list_std.rend());
+        ASSERT_EQUAL_MSG(reversed, reversed_std, "list::compact relinks prev pointers")
+
+        list_task.reverse();
+        list_std.reverse();
+        for (auto it = list_task.cbegin(); it != list_task.cend(); ) {
+            it = list_task.compact(it, 100);
+        }
+        ASSERT_EQUAL_MSG(list_task, list_std, "Incremental list::compact")
+
+        task::list<std::string> strings(100, "compact");
+        strings.compact();
+        ASSERT_TRUE(strings.size() == 100 and strings.back() == "compact")
+
+        // Without a node pool the new nodes are all taken before the old ones
+        // are freed, so an allocator that returns ascending addresses lays
+        // them out in list order.
+        task::list<size_t, BumpAllocator<size_t>> scattered(BumpAllocator<size_t>(std::make_shared<BumpArena>(1 << 20)));
+        std::vector<size_t> values;
+        for (size_t i = 0; i < 3000; ++i) {
+            auto pos = RandomUInt(values.size());
+            scattered.insert(std::next(scattered.cbegin(), pos), i);
+            values.insert(values.begin() + pos, i);
+        }
+
+        ASSERT_TRUE(not contiguous(scattered))
+        scattered.compact();
+        ASSERT_EQUAL_MSG(scattered, values, "list::compact with a plain allocator")
+        std::vector<size_t> reversed_scattered(scattered.rbegin(), scattered.rend());
+        ASSERT_TRUE(std::equal(reversed_scattered.begin(), reversed_scattered.end(), values.rbegin(), values.rend()))
+        ASSERT_TRUE_MSG(contiguous(scattered), "list::compact lays nodes out in order")
+    }
+
+    {
+        // Const queries on one list may rebuild its stale index concurrently.
+        task::list<size_t> list_task;
+        list_task.enable_index();
+        for (size_t i = 0; i < 20000; ++i) {
+            list_task.push_back(i);
+        }
+        list_task.reverse();
+
+        const auto& view = list_task;
+        std::atomic<bool> found(true);
+        std::vector<std::thread> readers;
+        for (size_t t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t] {
+                for (size_t i = t; i < view.size(); i += 997) {
+                    auto it = view.nth(i);
+                    if (*it != view.size() - 1 - i or view.position(it) != i) found = false;
+                }
+            });
+        }
+        for (auto& reader: readers) {
+            reader.join();
+        }
+        ASSERT_TRUE_MSG(found, "Concurrent const list::nth / position")
+    }
+
+    {
+        task::list<size_t> list_task;
+        std::vector<size_t> values;
+        list_task.enable_index();
+
+        auto check_positions = [&](const char* msg) {
+            ASSERT_TRUE_MSG(list_task.size() == values.size(), msg)
+            for (size_t i = 0; i < 50; ++i) {
+                auto pos = RandomUInt(values.size());
+                auto it = list_task.nth(pos);
+                ASSERT_TRUE_MSG(pos == values.size() ? it == list_task.end() : *it == values[pos], msg)
+                ASSERT_TRUE_MSG(list_task.position(it) == pos, msg)
+            }
+        };
+
+        for (size_t iter = 0; iter < 20000; ++iter) {
+            auto pos = RandomUInt(values.size());
+            auto val = RandomUInt();
+            switch (RandomUInt(4)) {
+                case 0:
+                case 1:
+                    list_task.insert(list_task.nth(pos), val);
+                    values.insert(values.begin() + pos, val);
+                    break;
+                case 2:
+                    if (pos < values.size()) {
+                        list_task.erase(list_task.nth(pos));
+                        values.erase(values.begin() + pos);
+                    }
+                    break;
+                case 3:
+                    if (pos < values.size()) {
+                        // Move to front.
+                        list_task.splice(list_task.cbegin(), list_task, list_task.nth(pos));
+                        std::rotate(values.begin(), values.begin() + pos, values.begin() + pos + 1);
+                    }
+                    break;
+                case 4:
+                    list_task.insert(list_task.nth(pos), 100, val);
+                    values.insert(values.begin() + pos, 100, val);
+                    break;
+            }
+            if (iter % 1000 == 0) {
+                check_positions("Indexed insert / erase / splice");
+            }
+        }
+        check_positions("Indexed insert / erase / splice");
+
+        list_task.sort();
+        std::sort(values.begin(), values.end());
+        check_positions("Index after sort");
+
+        list_task.resize(values.size() / 3);
+        values.resize(values.size() / 3);
+        check_positions("Index after resize");
+
+        task::list<size_t> other(10, 1);
+        other.enable_index();
+        other.splice(other.nth(5), list_task);
+        values.insert(values.begin(), 5, 1);
+        values.insert(values.end(), 5, 1);
+        ASSERT_TRUE(list_task.empty() and list_task.nth(0) == list_task.end())
+        list_task.swap(other);
+        check_positions("Index after whole-list splice");
+
+        list_task.enable_index(false);
+        check_positions("Positions without index");
+    }
+
+    {
+        using ArenaList = task::list<size_t, ArenaAllocator<size_t>>;
+        auto arena = std::make_shared<Arena>();
+        auto other_arena = std::make_shared<Arena>();
+        ArenaAllocator<size_t> alloc(arena), other_alloc(other_arena);
+
+        std::list<size_t> list_std;
+        RandomFill(list_std, 1000);
+        ArenaList list_task(list_std.begin(), list_std.end(), alloc);
+        ASSERT_TRUE_MSG(arena->live == 1000, "Nodes come from the given allocator")
+
+        ArenaList copy(list_task);
+        ASSERT_TRUE_MSG(copy.get_allocator() == alloc and arena->live == 2000, "Copy uses a copy of the allocator")
+
+        // Unequal allocators that do not propagate: the elements are moved
+        // into nodes of the target's arena.
+        ArenaList target(other_alloc);
+        target = std::move(copy);
+        ASSERT_EQUAL_MSG(target, list_std, "Move assignment between arenas")
+        ASSERT_TRUE_MSG(target.get_allocator() == other_alloc and other_arena->live == 1000,
+                        "Move assignment keeps the target's allocator")
+        copy.clear();
+
+        ArenaList moved(std::move(target), alloc);
+        ASSERT_EQUAL_MSG(moved, list_std, "Move construction into another arena")
+        target.clear();
+        ASSERT_TRUE_MSG(arena->live == 2000 and other_arena->live == 0, "Move construction into another arena")
+
+        // Equal allocators: nodes change hands without allocations.
+        auto allocated = arena->allocated;
+        ArenaList same(alloc);
+        same = std::move(moved);
+        same.swap(list_task);
+        ASSERT_EQUAL_MSG(same, list_std, "Move assignment and swap within an arena")
+        ASSERT_TRUE_MSG(moved.empty() and arena->allocated == allocated, "Move assignment and swap within an arena")
+
+        auto it = std::next(same.begin(), 10);
+        auto value = *it;
+        auto node = same.extract(it);
+        ASSERT_TRUE_MSG(node and node.value() == value and same.size() == 999, "list::extract")
+        auto pos = list_task.insert(list_task.cbegin(), std::move(node));
+        ASSERT_TRUE_MSG(node.empty() and *pos == value and list_task.size() == 1001, "list::insert of a node")
+        ASSERT_TRUE_MSG(arena->allocated == allocated and arena->live == 2000, "Node handles relink nodes")
+
+        auto dropped = list_task.extract(list_task.cbegin());
+        dropped = list_task.extract(list_task.cbegin());
+        ASSERT_TRUE_MSG(arena->live == 1999, "A node handle frees the node it owns")
+    }
+
+    {
+        // PoolAllocator propagates on move and swap, so no elements move.
+        using PoolList = task::list<size_t, task::PoolAllocator<size_t>>;
+        PoolList list_task(100, 1), other(50, 2);
+        auto pool = other.get_allocator();
+        list_task = std::move(other);
+        ASSERT_TRUE_MSG(list_task.get_allocator() == pool and list_task.size() == 50, "Pool moves with the nodes")
+
+        PoolList third(10, 3);
+        auto third_pool = third.get_allocator();
+        third.swap(list_task);
+        ASSERT_TRUE_MSG(third.get_allocator() == pool and list_task.get_allocator() == third_pool,
+                        "Pool swaps with the nodes")
+    }
+
+    {
+        task::thread_pool pool(3);
+        std::vector<size_t> values;
+        RandomFill(values, 100000, 1000);
+        task::list<size_t> list_task(values.begin(), values.end());
+
+        std::atomic<size_t> sum(0);
+        list_task.parallel_for_each([&sum](size_t value) { sum += value; }, pool);
+        auto expected = std::accumulate(values.begin(), values.end(), size_t(0));
+        ASSERT_TRUE_MSG(sum == expected, "list::parallel_for_each")
+        ASSERT_TRUE_MSG(list_task.parallel_reduce(size_t(0), std::plus<>(), pool) == expected, "list::parallel_reduce")
+
+        list_task.parallel_transform([](size_t value) { return value * value; }, pool);
+        std::transform(values.begin(), values.end(), values.begin(), [](size_t value) { return value * value; });
+        ASSERT_EQUAL_MSG(list_task, values, "list::parallel_transform")
+
+        // Chunks are cut and combined in list order.
+        task::list<std::string> words;
+        std::string joined;
+        for (auto value: values) {
+            words.push_back(std::to_string(value % 100) + ",");
+            joined += words.back();
+        }
+        words.enable_index();
+        ASSERT_TRUE_MSG(words.parallel_reduce(std::string(), std::plus<>(), pool) == joined,
+                        "list::parallel_reduce keeps the order")
+
+        task::list<size_t> small(10, 1);
+        ASSERT_TRUE_MSG(small.parallel_reduce(size_t(5), std::plus<>(), pool) == 15, "parallel_reduce of a short list")
+        task::list<size_t> empty;
+        ASSERT_TRUE_MSG(empty.parallel_reduce(size_t(5), std::plus<>(), pool) == 5, "parallel_reduce of an empty list")
+
+        // Work submitted from inside a task goes to the worker's own deque.
+        std::atomic<size_t> calls(0);
+        pool.parallel_for(16, [&](size_t) {
+            pool.parallel_for(16, [&](size_t) { ++calls; });
+        });
+        ASSERT_TRUE_MSG(calls == 256, "Nested thread_pool::parallel_for")
+    }
+
 }
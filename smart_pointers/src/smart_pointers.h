@@ -1,6 +1,8 @@
 #pragma once
 #include <type_traits>
 #include <atomic>
+#include <memory>
+#include <new>
 
 namespace task {
 
@@ -31,8 +33,18 @@ private:
     pointer data_ = nullptr;
 };
 
-template <class T> struct ControlBlock;
+// Reference counts shared by the owners of one object, together with the
+// way to destroy it. A block made by MakeShared or AllocateShared holds the
+// object itself, so object and counts take a single allocation.
+struct ControlBlockBase;
 template <class T> class WeakPtr;
+template <class T> class SharedPtr;
+
+template <class T, class... Args>
+SharedPtr<T> MakeShared(Args&&... args);
+
+template <class T, class Alloc, class... Args>
+SharedPtr<T> AllocateShared(const Alloc& alloc, Args&&... args);
 
 template <class T>
 class SharedPtr {
@@ -62,8 +74,15 @@ public:
 
 private:
     friend class WeakPtr<T>;
-    ControlBlock<pointer>* ctrl_block_ = nullptr;
+    template <class U, class Alloc, class... Args>
+    friend SharedPtr<U> AllocateShared(const Alloc& alloc, Args&&... args);
+
+    // Adopts one shared reference already counted in `ctrl_block`.
+    SharedPtr(pointer data, ControlBlockBase* ctrl_block);
 
+    // Kept next to the block so that access does not go through it.
+    pointer data_ = nullptr;
+    ControlBlockBase* ctrl_block_ = nullptr;
 };
 
 template <class T>
@@ -91,7 +110,8 @@ public:
 
 private:
     friend class SharedPtr<T>;
-    ControlBlock<pointer>* ctrl_block_ = nullptr;
+    pointer data_ = nullptr;
+    ControlBlockBase* ctrl_block_ = nullptr;
 };
 
 
@@ -54,25 +54,104 @@ void UniquePtr<T>::swap(UniquePtr& other) {
     std::swap(data_, other.data_);
 }
 
-template <class T> struct ControlBlock {
-    T data;
+// The shared owners together hold one weak reference, so the block goes
+// away with the last owner of either kind.
+struct ControlBlockBase {
     std::atomic_size_t shared_count;
     std::atomic_size_t weak_count;
-    ControlBlock(): data(nullptr), shared_count(0), weak_count(0) {};
+
+    ControlBlockBase(): shared_count(1), weak_count(1) {};
+    virtual ~ControlBlockBase() = default;
+
+    // Destroys the object once the last shared owner is gone.
+    virtual void destroy_object() = 0;
+    // Frees the block itself once the last weak owner is gone.
+    virtual void destroy_block() = 0;
+
+    // Takes a shared reference unless the object is already destroyed.
+    bool try_add_shared() {
+        auto count = shared_count.load();
+        while (count != 0) {
+            if (shared_count.compare_exchange_weak(count, count + 1)) return true;
+        }
+        return false;
+    }
+
+    void release_shared() {
+        if (--shared_count == 0) {
+            destroy_object();
+            release_weak();
+        }
+    }
+
+    void release_weak() {
+        if (--weak_count == 0) {
+            destroy_block();
+        }
+    }
+};
+
+// Block for an object created apart by the user with new.
+template <class T>
+struct PointerControlBlock: ControlBlockBase {
+    explicit PointerControlBlock(T* data): data(data) {};
+
+    void destroy_object() override {
+        delete data;
+    }
+
+    void destroy_block() override {
+        delete this;
+    }
+
+    T* data;
+};
+
+// Block with the object stored right after the counts, allocated with
+// `Alloc` rebound to the block type.
+template <class T, class Alloc>
+struct InplaceControlBlock: ControlBlockBase {
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<InplaceControlBlock>;
+    using ObjectAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+    explicit InplaceControlBlock(const Alloc& alloc): alloc(alloc) {};
+
+    T* object() {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    void destroy_object() override {
+        ObjectAlloc object_alloc(alloc);
+        std::allocator_traits<ObjectAlloc>::destroy(object_alloc, object());
+    }
+
+    void destroy_block() override {
+        BlockAlloc block_alloc(alloc);
+        this->~InplaceControlBlock();
+        std::allocator_traits<BlockAlloc>::deallocate(block_alloc, this, 1);
+    }
+
+    BlockAlloc alloc;
+    alignas(T) unsigned char storage[sizeof(T)];
 };
 
 
 template<class T>
-SharedPtr<T>::SharedPtr(SharedPtr<T>::pointer ptr): ctrl_block_(nullptr){
+SharedPtr<T>::SharedPtr(SharedPtr<T>::pointer ptr): data_(ptr), ctrl_block_(nullptr) {
     if (ptr) {
-        ctrl_block_ = new ControlBlock<decltype(ptr)>();
-        ctrl_block_->data = ptr;
-        ++ctrl_block_->shared_count;
+        ctrl_block_ = new PointerControlBlock<T>(ptr);
     }
 }
 
 template<class T>
-SharedPtr<T>::SharedPtr(SharedPtr&& other): ctrl_block_(other.ctrl_block_) {
+SharedPtr<T>::SharedPtr(SharedPtr<T>::pointer data, ControlBlockBase* ctrl_block):
+    data_(data), ctrl_block_(ctrl_block) {
+
+}
+
+template<class T>
+SharedPtr<T>::SharedPtr(SharedPtr&& other): data_(other.data_), ctrl_block_(other.ctrl_block_) {
+    other.data_ = nullptr;
     other.ctrl_block_ = nullptr;
 }
 
@@ -85,13 +164,17 @@ SharedPtr<T>& SharedPtr<T>::operator=(SharedPtr&& other) {
 }
 
 template<class T>
-SharedPtr<T>::SharedPtr(const SharedPtr& other): ctrl_block_(other.ctrl_block_) {
+SharedPtr<T>::SharedPtr(const SharedPtr& other): data_(other.data_), ctrl_block_(other.ctrl_block_) {
     if (ctrl_block_) ++ctrl_block_->shared_count;
 }
 
+// Stays empty if the object has already been destroyed.
 template<class T>
-SharedPtr<T>::SharedPtr(const WeakPtr<T>& other): ctrl_block_(other.ctrl_block_) {
-    if (ctrl_block_) ++ctrl_block_->shared_count;
+SharedPtr<T>::SharedPtr(const WeakPtr<T>& other) {
+    if (other.ctrl_block_ and other.ctrl_block_->try_add_shared()) {
+        data_ = other.data_;
+        ctrl_block_ = other.ctrl_block_;
+    }
 }
 
 template<class T>
@@ -109,45 +192,35 @@ SharedPtr<T>::~SharedPtr() {
 
 template<class T>
 typename std::add_lvalue_reference<typename SharedPtr<T>::element_type>::type SharedPtr<T>::operator*() const {
-    return *(ctrl_block_->data);
+    return *data_;
 }
 template<class T>
 typename SharedPtr<T>::pointer SharedPtr<T>::operator->() const {
-    return ctrl_block_->data;
+    return data_;
 }
 
 template<class T>
 typename SharedPtr<T>::pointer SharedPtr<T>::get() const {
-    return ctrl_block_ ? ctrl_block_->data : nullptr;
+    return data_;
 }
 
 template<class T>
 std::size_t SharedPtr<T>::use_count() const {
-    return ctrl_block_->shared_count;
+    return ctrl_block_ ? ctrl_block_->shared_count.load() : 0;
 }
 
+// Releases the current object, other owners keep it, and takes ownership
+// of `ptr`.
 template<class T>
 void SharedPtr<T>::reset(SharedPtr<T>::pointer ptr ) {
     if (ptr) {
-        if (ctrl_block_) {
-            delete ctrl_block_->data;
-            ctrl_block_->data = ptr;
-        }
-        else {
-            SharedPtr temp(ptr);
-            temp.swap(*this);
-        }
+        SharedPtr temp(ptr);
+        temp.swap(*this);
     } else if (ctrl_block_) {
-        if (--ctrl_block_->shared_count == 0) {
-            delete ctrl_block_->data;
-            ctrl_block_->data = nullptr;
-
-            if (ctrl_block_->weak_count == 0) {
-                delete ctrl_block_;
-            }
-        }
-
+        auto ctrl_block = ctrl_block_;
+        data_ = nullptr;
         ctrl_block_ = nullptr;
+        ctrl_block->release_shared();
     }
 }
 
@@ -155,17 +228,47 @@ template<class T>
 void SharedPtr<T>::swap(SharedPtr& other) {
     if (this == &other) return;
 
+    std::swap(data_, other.data_);
     std::swap(ctrl_block_, other.ctrl_block_);
 }
 
 
+template <class T, class... Args>
+SharedPtr<T> MakeShared(Args&&... args) {
+    return AllocateShared<T>(std::allocator<T>(), std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc, class... Args>
+SharedPtr<T> AllocateShared(const Alloc& alloc, Args&&... args) {
+    using Block = InplaceControlBlock<T, Alloc>;
+    using Traits = std::allocator_traits<typename Block::BlockAlloc>;
+
+    typename Block::BlockAlloc block_alloc(alloc);
+    auto block = Traits::allocate(block_alloc, 1);
+    ::new((void *)block) Block(alloc);
+
+    typename Block::ObjectAlloc object_alloc(alloc);
+    try {
+        std::allocator_traits<typename Block::ObjectAlloc>::construct(
+            object_alloc, block->object(), std::forward<Args>(args)...);
+    } catch (...) {
+        block->~Block();
+        Traits::deallocate(block_alloc, block, 1);
+        throw;
+    }
+
+    return SharedPtr<T>(block->object(), block);
+}
+
+
 template<class T>
-WeakPtr<T>::WeakPtr(const SharedPtr<T>& other): ctrl_block_(other.ctrl_block_) {
+WeakPtr<T>::WeakPtr(const SharedPtr<T>& other): data_(other.data_), ctrl_block_(other.ctrl_block_) {
     if (ctrl_block_) ++ctrl_block_->weak_count;
 }
 
 template<class T>
-WeakPtr<T>::WeakPtr(WeakPtr&& other): ctrl_block_(other.ctrl_block_) {
+WeakPtr<T>::WeakPtr(WeakPtr&& other): data_(other.data_), ctrl_block_(other.ctrl_block_) {
+    other.data_ = nullptr;
     other.ctrl_block_ = nullptr;
 }
 
@@ -178,7 +281,7 @@ WeakPtr<T>& WeakPtr<T>::operator=(WeakPtr&& other) {
 }
 
 template<class T>
-WeakPtr<T>::WeakPtr(const WeakPtr& other): ctrl_block_(other.ctrl_block_) {
+WeakPtr<T>::WeakPtr(const WeakPtr& other): data_(other.data_), ctrl_block_(other.ctrl_block_) {
     if (ctrl_block_) ++ctrl_block_->weak_count;
 }
 
@@ -214,11 +317,10 @@ std::size_t WeakPtr<T>::use_count() const {
 template<class T>
 void WeakPtr<T>::reset() {
     if (ctrl_block_) {
-        if (--ctrl_block_->weak_count == 0 and ctrl_block_->shared_count == 0) {
-            delete ctrl_block_;
-        }
-
+        auto ctrl_block = ctrl_block_;
+        data_ = nullptr;
         ctrl_block_ = nullptr;
+        ctrl_block->release_weak();
     }
 }
 
@@ -226,6 +328,7 @@ template<class T>
 void WeakPtr<T>::swap(WeakPtr& other) {
     if (this == &other) return;
 
+    std::swap(data_, other.data_);
     std::swap(ctrl_block_, other.ctrl_block_);
 }
 
@@ -8,6 +8,8 @@
 using task::UniquePtr;
 using task::SharedPtr;
 using task::WeakPtr;
+using task::MakeShared;
+using task::AllocateShared;
 
 
 size_t RandomUInt(size_t max = -1) {
@@ -53,6 +55,42 @@ SharedPtr<Node> getCyclePtr(int cycleSize) {
 }
 
 
+// Counts the live objects of the type.
+struct Tracked {
+    static int alive;
+    int value;
+    explicit Tracked(int value): value(value) { ++alive; }
+    ~Tracked() { --alive; }
+};
+
+int Tracked::alive = 0;
+
+// Counts allocations of all its rebinds in shared counters.
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator(size_t& allocations, size_t& live): allocations(&allocations), live(&live) {}
+
+    template <class U>
+    CountingAllocator(const CountingAllocator<U>& other): allocations(other.allocations), live(other.live) {}
+
+    T* allocate(size_t n) {
+        ++*allocations;
+        ++*live;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        --*live;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    size_t* allocations;
+    size_t* live;
+};
+
+
 void FailWithMsg(const std::string& msg, int line) {
     std::cerr << "Test failed!\n";
     std::cerr << "[Line " << line << "] "  << msg << std::endl;
@@ -193,4 +231,49 @@ int main() {
         }
     }
 
+    {
+        auto sp = MakeShared<std::string>(5, 'x');
+        ASSERT_TRUE(*sp == "xxxxx" and sp->size() == 5 and sp.use_count() == 1);
+        auto copy = sp;
+        ASSERT_TRUE(copy.get() == sp.get() and sp.use_count() == 2);
+
+        WeakPtr<Tracked> weak;
+        {
+            auto tracked = MakeShared<Tracked>(7);
+            weak = tracked;
+            ASSERT_TRUE(Tracked::alive == 1 and weak.lock()->value == 7);
+        }
+        // The object goes with the last owner, the block with the last weak.
+        ASSERT_TRUE(Tracked::alive == 0 and weak.expired());
+        ASSERT_TRUE(weak.lock().get() == nullptr and weak.lock().use_count() == 0);
+
+        size_t allocations = 0, live = 0;
+        {
+            CountingAllocator<Tracked> alloc(allocations, live);
+            auto tracked = AllocateShared<Tracked>(alloc, 42);
+            ASSERT_TRUE(allocations == 1 and tracked->value == 42);
+            WeakPtr<Tracked> tracked_weak = tracked;
+            tracked.reset();
+            ASSERT_TRUE(Tracked::alive == 0 and live == 1);
+        }
+        ASSERT_TRUE(allocations == 1 and live == 0);
+
+        auto first = MakeShared<Tracked>(1);
+        auto second = first;
+        second.reset(new Tracked(2));
+        ASSERT_TRUE(first->value == 1 and second->value == 2 and first.use_count() == 1);
+        first.reset();
+        second.reset();
+        ASSERT_TRUE(Tracked::alive == 0);
+
+        for (int i = 0; i < 100'000; ++i) {
+            auto head = MakeShared<Node>(0);
+            head->next.shared = MakeShared<Node>(1, WeakPtr<Node>(head));
+            auto next = head->next.shared;
+            ASSERT_TRUE(next.use_count() == 2 and next->next.weak.lock().get() == head.get());
+            head.reset();
+            ASSERT_TRUE(next.use_count() == 1 and next->next.weak.expired());
+        }
+    }
+
 }
@@ -0,0 +1,318 @@
+#pragma once
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <utility>
+#include <algorithm>
+
+#include "vector_ops.h"
+#include "vector_io.h"
+#include "parallel.h"
+#include "span.h"
+
+namespace task {
+
+enum class Metric: uint8_t {
+    kL2 = 0,            // squared euclidean distance
+    kInnerProduct = 1,  // negated dot product, smaller is more similar
+};
+
+// Approximate nearest-neighbour index with an inverted file (IVF) layout.
+// A k-means coarse quantizer splits the space into `lists` cells; every
+// vector is stored in the inverted list of its nearest centroid and a query
+// scans only the `nprobe` cells closest to it. Distances use the Dot kernel
+// of vector_ops.h, with precomputed norms for the L2 metric.
+//
+// Train and the batch operations run on several threads. Add/AddBatch and
+// Search must not run concurrently with each other, like for std containers.
+template<typename Tp>
+class IvfIndex {
+public:
+    using Id = uint64_t;
+    using Neighbour = std::pair<Tp, Id>;  // distance and id of a stored vector
+
+    IvfIndex(): IvfIndex(0, 0) {
+
+    }
+
+    IvfIndex(size_t dim, size_t lists, Metric metric = Metric::kL2):
+        dim_(dim), metric_(metric), size_(0), lists_(lists) {
+
+    }
+
+    size_t dim() const {
+        return dim_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t lists() const {
+        return lists_.size();
+    }
+
+    bool trained() const {
+        return not lists_.empty() and centroids_.size() == lists_.size() * dim_;
+    }
+
+    // Runs k-means over the rows of `block` to place the centroids. The
+    // assignment step, which dominates, is split between threads.
+    void Train(Span<const Tp> block, size_t iterations = 10, size_t threads = DefaultThreadCount(),
+               unsigned seed = 0) {
+        assert(dim_ != 0 and block.size() % dim_ == 0);
+        auto count = block.size() / dim_;
+        assert(count >= lists_.size());
+
+        std::vector<size_t> rows(count);
+        std::iota(rows.begin(), rows.end(), 0);
+        std::shuffle(rows.begin(), rows.end(), std::mt19937(seed));
+
+        centroids_.resize(lists_.size() * dim_);
+        for (size_t c = 0; c < lists_.size(); ++c)
+            std::copy_n(block.data() + rows[c] * dim_, dim_, centroids_.data() + c * dim_);
+        UpdateCentroidNorms();
+
+        std::vector<size_t> assignment(count);
+        for (size_t iter = 0; iter < iterations; ++iter) {
+            Assign(block, assignment, threads);
+
+            std::vector<Tp> sums(centroids_.size());
+            std::vector<size_t> sizes(lists_.size());
+            for (size_t i = 0; i < count; ++i) {
+                auto c = assignment[i];
+                ++sizes[c];
+                auto row = block.data() + i * dim_;
+                auto sum = sums.data() + c * dim_;
+                for (size_t d = 0; d < dim_; ++d)
+                    sum[d] += row[d];
+            }
+
+            // An empty cell keeps its previous centroid.
+            for (size_t c = 0; c < lists_.size(); ++c) {
+                if (sizes[c] == 0) continue;
+                for (size_t d = 0; d < dim_; ++d)
+                    centroids_[c * dim_ + d] = sums[c * dim_ + d] / Tp(sizes[c]);
+            }
+            UpdateCentroidNorms();
+        }
+    }
+
+    // Inserts one vector and returns its id; ids are assigned sequentially.
+    Id Add(Span<const Tp> vec) {
+        assert(trained() and vec.size() == dim_);
+        auto id = Id(size_);
+        Append(Nearest(vec.data(), 1).front(), id, vec.data());
+        return id;
+    }
+
+    // Inserts the rows of `block`, finding their cells on several threads.
+    // Returns the id of the first row; the others follow consecutively.
+    Id AddBatch(Span<const Tp> block, size_t threads = DefaultThreadCount()) {
+        assert(trained() and block.size() % dim_ == 0);
+        auto count = block.size() / dim_;
+        std::vector<size_t> assignment(count);
+        Assign(block, assignment, threads);
+
+        auto first = Id(size_);
+        for (size_t i = 0; i < count; ++i)
+            Append(assignment[i], first + i, block.data() + i * dim_);
+
+        return first;
+    }
+
+    // Returns up to `k` nearest stored vectors, closest first.
+    std::vector<Neighbour> Search(Span<const Tp> query, size_t k, size_t nprobe = 1) const {
+        assert(trained() and query.size() == dim_);
+        auto q = query.data();
+        auto query_norm2 = Dot(q, q, dim_);
+
+        std::priority_queue<Neighbour> best;
+        for (auto c: Nearest(q, nprobe)) {
+            const auto& list = lists_[c];
+            for (size_t i = 0; i < list.ids.size(); ++i) {
+                auto dist = Distance(q, query_norm2, list.vectors.data() + i * dim_, list.norms[i]);
+                if (best.size() < k) {
+                    best.emplace(dist, list.ids[i]);
+                } else if (k != 0 and Neighbour(dist, list.ids[i]) < best.top()) {
+                    best.pop();
+                    best.emplace(dist, list.ids[i]);
+                }
+            }
+        }
+
+        std::vector<Neighbour> res(best.size());
+        for (auto it = res.rbegin(); it != res.rend(); ++it) {
+            *it = best.top();
+            best.pop();
+        }
+
+        return res;
+    }
+
+    // Searches every row of `block`, splitting the queries between threads.
+    std::vector<std::vector<Neighbour>> SearchBatch(Span<const Tp> block, size_t k, size_t nprobe = 1,
+                                                    size_t threads = DefaultThreadCount()) const {
+        assert(block.size() % dim_ == 0);
+        std::vector<std::vector<Neighbour>> res(block.size() / dim_);
+        ParallelFor(res.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                res[i] = Search(block.subspan(i * dim_, dim_), k, nprobe);
+        }, threads);
+
+        return res;
+    }
+
+    // Binary form of a trained index, made of vector_io.h frames: an empty frame recording the
+    // element type, the dimensions and metric, the centroids, then the ids and
+    // vectors of every inverted list.
+    std::ostream& Save(std::ostream& out) const {
+        assert(trained());
+        uint64_t meta[] = {dim_, lists_.size(), static_cast<uint64_t>(metric_), size_};
+        WriteBinary(out, Span<const Tp>());
+        WriteBinary(out, Span<const uint64_t>(meta, 4));
+        WriteBinary(out, centroids_);
+        for (const auto& list: lists_) {
+            WriteBinary(out, list.ids);
+            WriteBinary(out, list.vectors);
+        }
+
+        return out;
+    }
+
+    // Replaces the contents of the index; sets failbit on malformed input
+    // and leaves the index untouched in that case. Frames are read with
+    // ReadBinary, which allocates no more than the data that arrives.
+    std::istream& Load(std::istream& in) {
+        std::vector<uint64_t> meta;
+        if (not ReadIndexHeader(in) or not ReadBinary(in, meta))
+            return in;
+
+        if (meta.size() != 4 or meta[2] > static_cast<uint64_t>(Metric::kInnerProduct)) {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        // Only trained indices are saved, so the centroids bound the number of
+        // lists before anything is allocated for them.
+        std::vector<Tp> centroids;
+        if (not ReadBinary(in, centroids))
+            return in;
+
+        if (meta[0] == 0 or meta[1] == 0 or centroids.size() / meta[0] != meta[1] or
+            centroids.size() % meta[0] != 0) {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        IvfIndex res(meta[0], meta[1], static_cast<Metric>(meta[2]));
+        res.centroids_.swap(centroids);
+
+        for (auto& list: res.lists_) {
+            if (not ReadBinary(in, list.ids) or not ReadBinary(in, list.vectors))
+                return in;
+            if (list.vectors.size() != list.ids.size() * res.dim_) {
+                in.setstate(std::ios::failbit);
+                return in;
+            }
+            list.norms.resize(list.ids.size());
+            for (size_t i = 0; i < list.ids.size(); ++i)
+                list.norms[i] = Dot(list.vectors.data() + i * res.dim_, list.vectors.data() + i * res.dim_, res.dim_);
+            res.size_ += list.ids.size();
+        }
+
+        if (res.size_ != meta[3]) {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        // Add hands out ids from size(), so the stored ids must be exactly
+        // 0 .. size() - 1. The total was checked above, so `seen` is bounded
+        // by the data read.
+        std::vector<bool> seen(res.size_);
+        for (const auto& list: res.lists_) {
+            for (auto id: list.ids) {
+                if (id >= res.size_ or seen[id]) {
+                    in.setstate(std::ios::failbit);
+                    return in;
+                }
+                seen[id] = true;
+            }
+        }
+
+        res.UpdateCentroidNorms();
+        *this = std::move(res);
+        return in;
+    }
+
+private:
+    struct InvertedList {
+        std::vector<Id> ids;
+        std::vector<Tp> vectors;  // row-major, dim_ values per id
+        std::vector<Tp> norms;    // squared norms of the rows
+    };
+
+    bool ReadIndexHeader(std::istream& in) {
+        std::vector<Tp> empty;
+        return ReadBinary(in, empty) and empty.empty();
+    }
+
+    Tp Distance(const Tp* query, Tp query_norm2, const Tp* row, Tp row_norm2) const {
+        auto dot = Dot(query, row, dim_);
+        return metric_ == Metric::kL2 ? query_norm2 - 2 * dot + row_norm2 : -dot;
+    }
+
+    // Indices of the `count` cells closest to `vec`, closest first.
+    std::vector<size_t> Nearest(const Tp* vec, size_t count) const {
+        auto vec_norm2 = Dot(vec, vec, dim_);
+        std::vector<Neighbour> dist(lists_.size());
+        for (size_t c = 0; c < lists_.size(); ++c)
+            dist[c] = {Distance(vec, vec_norm2, centroids_.data() + c * dim_, centroid_norms_[c]), c};
+
+        count = std::min(count, dist.size());
+        std::partial_sort(dist.begin(), dist.begin() + count, dist.end());
+
+        std::vector<size_t> res(count);
+        for (size_t i = 0; i < count; ++i)
+            res[i] = dist[i].second;
+
+        return res;
+    }
+
+    void Assign(Span<const Tp> block, std::vector<size_t>& assignment, size_t threads) const {
+        ParallelFor(assignment.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                assignment[i] = Nearest(block.data() + i * dim_, 1).front();
+        }, threads, 256);
+    }
+
+    void Append(size_t cell, Id id, const Tp* vec) {
+        auto& list = lists_[cell];
+        list.ids.push_back(id);
+        list.vectors.insert(list.vectors.end(), vec, vec + dim_);
+        list.norms.push_back(Dot(vec, vec, dim_));
+        ++size_;
+    }
+
+    void UpdateCentroidNorms() {
+        centroid_norms_.resize(lists_.size());
+        if (centroids_.empty()) return;
+        for (size_t c = 0; c < lists_.size(); ++c)
+            centroid_norms_[c] = Dot(centroids_.data() + c * dim_, centroids_.data() + c * dim_, dim_);
+    }
+
+    size_t dim_;
+    Metric metric_;
+    size_t size_;
+    std::vector<Tp> centroids_;
+    std::vector<Tp> centroid_norms_;
+    std::vector<InvertedList> lists_;
+};
+
+}  // namespace task
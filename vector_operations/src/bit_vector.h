@@ -0,0 +1,205 @@
+#pragma once
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+
+namespace task {
+
+// Packed vector of flags, one bit per element. Word-wise loops over uint64_t
+// storage are vectorized by the compiler, and counting uses the hardware
+// popcount. Bits past size() in the last word are always kept zero.
+class BitVector {
+public:
+    using Word = uint64_t;
+    static constexpr size_t kWordBits = 64;
+
+    BitVector(): size_(0) {
+
+    }
+
+    explicit BitVector(size_t size, bool value = false):
+        words_(WordCount(size), value ? ~Word{0} : Word{0}), size_(size) {
+        ClearTail();
+    }
+
+    // Non-zero elements of the `operator|` / `operator&` form become set bits.
+    template<typename Tp>
+    explicit BitVector(const std::vector<Tp>& flags): BitVector(flags.size()) {
+        auto data = flags.data();
+        for (size_t w = 0; w < words_.size(); ++w) {
+            auto begin = w * kWordBits;
+            auto count = std::min(kWordBits, size_ - begin);
+            Word word = 0;
+            for (size_t i = 0; i < count; ++i)
+                word |= Word(data[begin + i] != Tp{}) << i;
+            words_[w] = word;
+        }
+    }
+
+    template<typename Tp = int>
+    std::vector<Tp> ToVector() const {
+        std::vector<Tp> res(size_);
+        for (size_t i = 0; i < size_; ++i)
+            res[i] = Tp(test(i));
+
+        return res;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool test(size_t i) const {
+        assert(i < size_);
+        return (words_[i / kWordBits] >> (i % kWordBits)) & 1;
+    }
+
+    void set(size_t i, bool value = true) {
+        assert(i < size_);
+        auto mask = Word{1} << (i % kWordBits);
+        auto& word = words_[i / kWordBits];
+        word = value ? word | mask : word & ~mask;
+    }
+
+    void reset(size_t i) {
+        set(i, false);
+    }
+
+    void push_back(bool value) {
+        if (size_ % kWordBits == 0)
+            words_.push_back(0);
+        ++size_;
+        set(size_ - 1, value);
+    }
+
+    const std::vector<Word>& words() const {
+        return words_;
+    }
+
+    BitVector& operator|=(const BitVector& other) {
+        return Apply(other, [](Word l, Word r) {return l | r;});
+    }
+
+    BitVector& operator&=(const BitVector& other) {
+        return Apply(other, [](Word l, Word r) {return l & r;});
+    }
+
+    BitVector& operator^=(const BitVector& other) {
+        return Apply(other, [](Word l, Word r) {return l ^ r;});
+    }
+
+    // this = this & ~other
+    BitVector& AndNot(const BitVector& other) {
+        return Apply(other, [](Word l, Word r) {return l & ~r;});
+    }
+
+    BitVector& Flip() {
+        for (auto& word: words_)
+            word = ~word;
+        ClearTail();
+        return *this;
+    }
+
+    size_t Count() const {
+        size_t res = 0;
+        for (auto word: words_)
+            res += __builtin_popcountll(word);
+
+        return res;
+    }
+
+    // Calls `func(i)` for every set bit in increasing order, skipping empty
+    // words and jumping between set bits with count-trailing-zeros.
+    template<typename Func>
+    void ForEachSetBit(Func func) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            for (auto word = words_[w]; word; word &= word - 1)
+                func(w * kWordBits + __builtin_ctzll(word));
+        }
+    }
+
+    std::vector<size_t> SetBits() const {
+        std::vector<size_t> res;
+        res.reserve(Count());
+        ForEachSetBit([&res](size_t i) {res.push_back(i);});
+        return res;
+    }
+
+    bool operator==(const BitVector& other) const {
+        return size_ == other.size_ and words_ == other.words_;
+    }
+
+    bool operator!=(const BitVector& other) const {
+        return not (*this == other);
+    }
+
+private:
+    static size_t WordCount(size_t size) {
+        return (size + kWordBits - 1) / kWordBits;
+    }
+
+    void ClearTail() {
+        if (size_ % kWordBits)
+            words_.back() &= (Word{1} << (size_ % kWordBits)) - 1;
+    }
+
+    template<typename Op>
+    BitVector& Apply(const BitVector& other, Op op) {
+        assert(size_ == other.size_);
+        auto l = words_.data();
+        auto r = other.words_.data();
+        auto count = words_.size();
+        for (size_t i = 0; i < count; ++i)
+            l[i] = op(l[i], r[i]);
+
+        return *this;
+    }
+
+    std::vector<Word> words_;
+    size_t size_;
+};
+
+inline BitVector operator|(BitVector left, const BitVector& right) {
+    return left |= right;
+}
+
+inline BitVector operator&(BitVector left, const BitVector& right) {
+    return left &= right;
+}
+
+inline BitVector operator^(BitVector left, const BitVector& right) {
+    return left ^= right;
+}
+
+inline BitVector AndNot(BitVector left, const BitVector& right) {
+    return left.AndNot(right);
+}
+
+// Popcount of a word-wise combination without materializing it.
+template<typename Op>
+size_t CountCombined(const BitVector& left, const BitVector& right, Op op) {
+    assert(left.size() == right.size());
+    auto l = left.words().data();
+    auto r = right.words().data();
+    auto count = left.words().size();
+
+    size_t res = 0;
+    for (size_t i = 0; i < count; ++i)
+        res += __builtin_popcountll(op(l[i], r[i]));
+
+    return res;
+}
+
+inline size_t HammingDistance(const BitVector& left, const BitVector& right) {
+    return CountCombined(left, right, [](BitVector::Word l, BitVector::Word r) {return l ^ r;});
+}
+
+// |left & right| / |left | right|; two empty sets are considered identical.
+inline double JaccardSimilarity(const BitVector& left, const BitVector& right) {
+    auto intersection = CountCombined(left, right, [](BitVector::Word l, BitVector::Word r) {return l & r;});
+    auto united = CountCombined(left, right, [](BitVector::Word l, BitVector::Word r) {return l | r;});
+    return united ? double(intersection) / united : 1.;
+}
+
+}  // namespace task
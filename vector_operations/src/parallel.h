@@ -0,0 +1,36 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace task {
+
+inline size_t DefaultThreadCount() {
+    auto count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+// Splits [0, count) into at most `threads` contiguous chunks of at least
+// `min_chunk` items and calls `body(begin, end)` for each chunk on its own
+// thread. The calling thread processes the first chunk itself.
+template<typename Body>
+void ParallelFor(size_t count, Body body, size_t threads = DefaultThreadCount(), size_t min_chunk = 1) {
+    if (count == 0) return;
+
+    min_chunk = std::max<size_t>(min_chunk, 1);
+    threads = std::max<size_t>(1, std::min(threads, (count + min_chunk - 1) / min_chunk));
+    auto chunk = (count + threads - 1) / threads;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+        workers.emplace_back(body, begin, std::min(begin + chunk, count));
+    }
+
+    body(0, std::min(chunk, count));
+
+    for (auto& worker: workers)
+        worker.join();
+}
+
+}  // namespace task
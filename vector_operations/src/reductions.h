@@ -0,0 +1,129 @@
+#pragma once
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "vector_ops.h"
+#include "parallel.h"
+
+namespace task {
+
+// Reductions over long vectors with results that do not depend on the number
+// of threads. The input is cut into fixed leaves of kReduceLeaf elements, each
+// leaf is reduced serially in a fixed order, and the leaf results are combined
+// by a pairwise tree whose shape depends only on the input size. Threads only
+// decide who computes which leaf, so every run gives bit-identical results.
+// The functions accept std::vector or Span.
+
+constexpr size_t kReduceLeaf = 1 << 12;
+
+template<typename Result, typename Leaf, typename Combine>
+Result TreeReduce(size_t size, Leaf leaf, Combine combine, size_t threads) {
+    auto leaves = (size + kReduceLeaf - 1) / kReduceLeaf;
+    std::vector<Result> partial(leaves);
+    ParallelFor(leaves, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            partial[i] = leaf(i * kReduceLeaf, std::min(size, (i + 1) * kReduceLeaf));
+    }, threads, 16);
+
+    for (auto count = leaves; count > 1; count = (count + 1) / 2) {
+        for (size_t i = 0; i < count / 2; ++i)
+            partial[i] = combine(partial[2 * i], partial[2 * i + 1]);
+        if (count % 2)
+            partial[count / 2] = partial[count - 1];
+    }
+
+    return partial[0];
+}
+
+template<typename Container>
+using ElementOf = std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const Container&>().data())>>;
+
+template<typename Container>
+auto ParallelSum(const Container& vec, size_t threads = DefaultThreadCount()) {
+    using Tp = ElementOf<Container>;
+    if (vec.size() == 0) return Tp{};
+
+    auto data = vec.data();
+    return TreeReduce<Tp>(vec.size(), [data](size_t begin, size_t end) {
+        Tp acc[4] = {};
+        auto i = begin;
+        for (; i + 4 <= end; i += 4) {
+            acc[0] += data[i];
+            acc[1] += data[i + 1];
+            acc[2] += data[i + 2];
+            acc[3] += data[i + 3];
+        }
+        for (; i < end; ++i)
+            acc[0] += data[i];
+
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }, std::plus<Tp>(), threads);
+}
+
+template<typename Container>
+auto ParallelDot(const Container& left, const Container& right, size_t threads = DefaultThreadCount()) {
+    using Tp = ElementOf<Container>;
+    assert(left.size() == right.size());
+    if (left.size() == 0) return Tp{};
+
+    auto l = left.data();
+    auto r = right.data();
+    return TreeReduce<Tp>(left.size(), [l, r](size_t begin, size_t end) {
+        return Dot(l + begin, r + begin, end - begin);
+    }, std::plus<Tp>(), threads);
+}
+
+template<typename Container>
+auto ParallelNorm(const Container& vec, size_t threads = DefaultThreadCount()) {
+    return std::sqrt(ParallelDot(vec, vec, threads));
+}
+
+template<typename Container>
+auto ParallelMin(const Container& vec, size_t threads = DefaultThreadCount()) {
+    using Tp = ElementOf<Container>;
+    assert(vec.size() != 0);
+
+    auto data = vec.data();
+    return TreeReduce<Tp>(vec.size(), [data](size_t begin, size_t end) {
+        return *std::min_element(data + begin, data + end);
+    }, [](const Tp& l, const Tp& r) {return std::min(l, r);}, threads);
+}
+
+template<typename Container>
+auto ParallelMax(const Container& vec, size_t threads = DefaultThreadCount()) {
+    using Tp = ElementOf<Container>;
+    assert(vec.size() != 0);
+
+    auto data = vec.data();
+    return TreeReduce<Tp>(vec.size(), [data](size_t begin, size_t end) {
+        return *std::max_element(data + begin, data + end);
+    }, [](const Tp& l, const Tp& r) {return std::max(l, r);}, threads);
+}
+
+// Index of the first maximal element, like std::max_element.
+template<typename Container>
+size_t ParallelArgMax(const Container& vec, size_t threads = DefaultThreadCount()) {
+    assert(vec.size() != 0);
+
+    auto data = vec.data();
+    return TreeReduce<size_t>(vec.size(), [data](size_t begin, size_t end) {
+        return size_t(std::max_element(data + begin, data + end) - data);
+    }, [data](size_t l, size_t r) {return data[l] < data[r] ? r : l;}, threads);
+}
+
+// Index of the first minimal element, like std::min_element.
+template<typename Container>
+size_t ParallelArgMin(const Container& vec, size_t threads = DefaultThreadCount()) {
+    assert(vec.size() != 0);
+
+    auto data = vec.data();
+    return TreeReduce<size_t>(vec.size(), [data](size_t begin, size_t end) {
+        return size_t(std::min_element(data + begin, data + end) - data);
+    }, [data](size_t l, size_t r) {return data[r] < data[l] ? r : l;}, threads);
+}
+
+}  // namespace task
@@ -0,0 +1,223 @@
+#pragma once
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#include "vector_ops.h"
+
+namespace task {
+
+// Fixed-size vector with inline storage. It is an aggregate, so
+// `Vec<double, 3>{1., 2., 3.}` involves no allocation, and every operation
+// below expands over an index sequence, i.e. is unrolled at compile time.
+template<typename Tp, size_t N>
+struct Vec {
+    using value_type = Tp;
+
+    Tp data[N];
+
+    static constexpr size_t size() {
+        return N;
+    }
+
+    constexpr Tp& operator[](size_t i) {
+        return data[i];
+    }
+
+    constexpr const Tp& operator[](size_t i) const {
+        return data[i];
+    }
+
+    constexpr Tp* begin() {
+        return data;
+    }
+
+    constexpr Tp* end() {
+        return data + N;
+    }
+
+    constexpr const Tp* begin() const {
+        return data;
+    }
+
+    constexpr const Tp* end() const {
+        return data + N;
+    }
+
+    explicit operator std::vector<Tp>() const {
+        return std::vector<Tp>(begin(), end());
+    }
+};
+
+template<typename Tp, size_t N, size_t... I>
+constexpr Vec<Tp, N> ToVecImpl(const Tp* data, std::index_sequence<I...>) {
+    return {{data[I]...}};
+}
+
+template<size_t N, typename Tp>
+Vec<Tp, N> ToVec(const std::vector<Tp>& vec) {
+    assert(vec.size() == N);
+    return ToVecImpl<Tp, N>(vec.data(), std::make_index_sequence<N>());
+}
+
+template<typename Tp, size_t N>
+std::vector<Tp> ToVector(const Vec<Tp, N>& vec) {
+    return std::vector<Tp>(vec);
+}
+
+template<typename Tp, size_t N, typename Op, size_t... I>
+constexpr Vec<Tp, N> ZipImpl(const Vec<Tp, N>& left, const Vec<Tp, N>& right, Op op, std::index_sequence<I...>) {
+    return {{op(left[I], right[I])...}};
+}
+
+template<typename Tp, size_t N, typename Op>
+constexpr Vec<Tp, N> Zip(const Vec<Tp, N>& left, const Vec<Tp, N>& right, Op op) {
+    return ZipImpl(left, right, op, std::make_index_sequence<N>());
+}
+
+template<typename Tp, size_t N, typename Op, size_t... I>
+constexpr Vec<Tp, N> MapImpl(const Vec<Tp, N>& vec, Op op, std::index_sequence<I...>) {
+    return {{op(vec[I])...}};
+}
+
+template<typename Tp, size_t N, typename Op>
+constexpr Vec<Tp, N> Map(const Vec<Tp, N>& vec, Op op) {
+    return MapImpl(vec, op, std::make_index_sequence<N>());
+}
+
+template<typename Tp, size_t N, size_t... I>
+constexpr Tp DotImpl(const Vec<Tp, N>& left, const Vec<Tp, N>& right, std::index_sequence<I...>) {
+    return (Tp{} + ... + (left[I] * right[I]));
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator+(const Vec<Tp, N>& vec) {
+    return vec;
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator-(const Vec<Tp, N>& vec) {
+    return Map(vec, std::negate<Tp>());
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator+(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return Zip(left, right, std::plus<Tp>());
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator-(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return Zip(left, right, std::minus<Tp>());
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator|(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return Zip(left, right, std::bit_or<Tp>());
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator&(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return Zip(left, right, std::bit_and<Tp>());
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator*(const Vec<Tp, N>& vec, const Tp& scalar) {
+    return Map(vec, [scalar](const Tp& item) {return item * scalar;});
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N> operator*(const Tp& scalar, const Vec<Tp, N>& vec) {
+    return vec * scalar;
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N>& operator+=(Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return left = left + right;
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N>& operator-=(Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return left = left - right;
+}
+
+template<typename Tp, size_t N>
+constexpr Vec<Tp, N>& operator*=(Vec<Tp, N>& vec, const Tp& scalar) {
+    return vec = vec * scalar;
+}
+
+template<typename Tp, size_t N>
+constexpr Tp operator*(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return DotImpl(left, right, std::make_index_sequence<N>());
+}
+
+template<typename Tp>
+constexpr Vec<Tp, 3> operator%(const Vec<Tp, 3>& left, const Vec<Tp, 3>& right) {
+    return {{left[1] * right[2] - left[2] * right[1], left[2] * right[0] - left[0] * right[2],
+             left[0] * right[1] - left[1] * right[0]}};
+}
+
+template<typename Tp, size_t N>
+Tp Norm(const Vec<Tp, N>& vec) {
+    return std::sqrt(vec * vec);
+}
+
+template<typename Tp, size_t N, size_t... I>
+constexpr bool EqualImpl(const Vec<Tp, N>& left, const Vec<Tp, N>& right, std::index_sequence<I...>) {
+    return (true and ... and (left[I] == right[I]));
+}
+
+template<typename Tp, size_t N>
+constexpr bool operator==(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return EqualImpl(left, right, std::make_index_sequence<N>());
+}
+
+template<typename Tp, size_t N>
+constexpr bool operator!=(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return not (left == right);
+}
+
+// Decided by CollinearFlag from the dot product and the norms, so the
+// tolerance is on the angle. The std::vector operator compares elements
+// within 1e-4 instead and may disagree for nearly collinear or very short
+// vectors.
+template<typename Tp, size_t N>
+int operator||(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return CollinearFlag(left * right, left * left, right * right, DefaultCollinearTolerance<Tp>());
+}
+
+template<typename Tp, size_t N>
+bool operator&&(const Vec<Tp, N>& left, const Vec<Tp, N>& right) {
+    return (left || right) == 1;
+}
+
+// Same text format as the std::vector stream operators: the input starts with
+// the element count, which has to be N.
+template<typename Tp, size_t N>
+std::istream& operator>>(std::istream& in, Vec<Tp, N>& dest) {
+    size_t n;
+    if (in >> n and n != N) {
+        in.setstate(std::ios::failbit);
+        return in;
+    }
+
+    for (auto& item: dest)
+        in >> item;
+
+    return in;
+}
+
+template<typename Tp, size_t N, size_t... I>
+void PrintImpl(std::ostream& out, const Vec<Tp, N>& source, std::index_sequence<I...>) {
+    ((out << source[I] << (I == N - 1 ? '\n' : ' ')), ...);
+}
+
+template<typename Tp, size_t N>
+std::ostream& operator<<(std::ostream& out, const Vec<Tp, N>& source) {
+    PrintImpl(out, source, std::make_index_sequence<N>());
+    return out;
+}
+
+}  // namespace task
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <cassert>
+#include <type_traits>
+
+namespace task {
+
+// Non-owning view of `size` contiguous elements: a slice of a larger buffer,
+// a Matrix row (`Span<double>(row.begin(), row.end())`), memory-mapped data
+// and so on. Span<const Tp> is the read-only form; both convert implicitly
+// from std::vector.
+template<typename Tp>
+class Span {
+public:
+    using element_type = Tp;
+    using value_type = std::remove_cv_t<Tp>;
+
+    Span(): data_(nullptr), size_(0) {
+
+    }
+
+    Span(Tp* data, size_t size): data_(data), size_(size) {
+
+    }
+
+    Span(Tp* begin, Tp* end): data_(begin), size_(end - begin) {
+
+    }
+
+    template<typename Alloc>
+    Span(std::vector<value_type, Alloc>& vec): data_(vec.data()), size_(vec.size()) {
+
+    }
+
+    template<typename Alloc, typename = std::enable_if_t<std::is_const<Tp>::value, Alloc>>
+    Span(const std::vector<value_type, Alloc>& vec): data_(vec.data()), size_(vec.size()) {
+
+    }
+
+    template<typename Up, typename = std::enable_if_t<std::is_convertible<Up(*)[], Tp(*)[]>::value>>
+    Span(const Span<Up>& other): data_(other.data()), size_(other.size()) {
+
+    }
+
+    Tp* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    Tp& operator[](size_t i) const {
+        assert(i < size_);
+        return data_[i];
+    }
+
+    Tp* begin() const {
+        return data_;
+    }
+
+    Tp* end() const {
+        return data_ + size_;
+    }
+
+    Span subspan(size_t offset, size_t count) const {
+        assert(offset + count <= size_);
+        return {data_ + offset, count};
+    }
+
+    Span subspan(size_t offset) const {
+        assert(offset <= size_);
+        return {data_ + offset, size_ - offset};
+    }
+
+private:
+    Tp* data_;
+    size_t size_;
+};
+
+template<typename Tp>
+struct Identity {
+    using type = Tp;
+};
+
+// Excludes a parameter from template argument deduction, so that a
+// std::vector or a mutable span converts to the Span<const Tp> expected there
+// once Tp is deduced from another argument.
+template<typename Tp>
+using NonDeduced = typename Identity<Tp>::type;
+
+}  // namespace task
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <cassert>
+
+#include "vector_ops.h"
+#include "parallel.h"
+
+namespace task {
+
+// Batched versions of `operator||` / `operator&&` for many vectors stored as a
+// row-major block of `dim`-sized rows. Results use the `operator||` encoding:
+// 1 for codirected, -1 for opposite, 0 for non-collinear vectors.
+//
+// Instead of discovering a ratio element by element, each pair is decided by
+// CollinearFlag from one dot product and the precomputed row norms, so the
+// per-pair work is a vectorized dot product plus a few branch-free
+// comparisons.
+
+template<typename Tp>
+std::vector<Tp> RowNorms2(const std::vector<Tp>& block, size_t dim, size_t threads = DefaultThreadCount()) {
+    assert(dim != 0 and block.size() % dim == 0);
+    auto count = block.size() / dim;
+    std::vector<Tp> norms(count);
+
+    auto data = block.data();
+    ParallelFor(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            norms[i] = Dot(data + i * dim, data + i * dim, dim);
+    }, threads, 1024);
+
+    return norms;
+}
+
+// Tests `query` against every row of `block`. `tolerance` bounds the squared
+// sine of the angle, as in CollinearFlag; the eager `operator||` uses an
+// absolute per-element tolerance instead, so for nearly collinear rows the
+// flags may differ from it.
+template<typename Tp>
+std::vector<int> Collinearity(const std::vector<Tp>& query, const std::vector<Tp>& block,
+                              Tp tolerance = DefaultCollinearTolerance<Tp>(),
+                              size_t threads = DefaultThreadCount()) {
+    auto dim = query.size();
+    assert(dim != 0 and block.size() % dim == 0);
+    auto count = block.size() / dim;
+    std::vector<int> res(count);
+
+    auto q = query.data();
+    auto query_norm2 = Dot(q, q, dim);
+    auto data = block.data();
+    ParallelFor(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto row = data + i * dim;
+            res[i] = CollinearFlag(Dot(q, row, dim), query_norm2, Dot(row, row, dim), tolerance);
+        }
+    }, threads, 1024);
+
+    return res;
+}
+
+// Tests every pair of rows of `block`; returns a symmetric count x count
+// row-major matrix of flags. Rows are independent, so each thread fills a
+// contiguous range of them without sharing cache lines with the others.
+// Same angle-based tolerance as Collinearity.
+template<typename Tp>
+std::vector<int> PairwiseCollinearity(const std::vector<Tp>& block, size_t dim,
+                                      Tp tolerance = DefaultCollinearTolerance<Tp>(),
+                                      size_t threads = DefaultThreadCount()) {
+    auto norms = RowNorms2(block, dim, threads);
+    auto count = norms.size();
+    std::vector<int> res(count * count);
+
+    auto data = block.data();
+    ParallelFor(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto row = data + i * dim;
+            auto out = res.data() + i * count;
+            for (size_t j = 0; j < count; ++j)
+                out[j] = CollinearFlag(Dot(row, data + j * dim, dim), norms[i], norms[j], tolerance);
+        }
+    }, threads, 16);
+
+    return res;
+}
+
+// Batched `operator&&`: 1 where the row is codirected with `query`, with the
+// angle-based tolerance of Collinearity.
+template<typename Tp>
+std::vector<int> Codirectionality(const std::vector<Tp>& query, const std::vector<Tp>& block,
+                                  Tp tolerance = DefaultCollinearTolerance<Tp>(),
+                                  size_t threads = DefaultThreadCount()) {
+    auto res = Collinearity(query, block, tolerance, threads);
+    for (auto& flag: res)
+        flag = flag == 1;
+
+    return res;
+}
+
+}  // namespace task
@@ -0,0 +1,301 @@
+#pragma once
+#include <vector>
+#include <cassert>
+#include <functional>
+#include <type_traits>
+
+#include "vector_ops.h"
+
+namespace task {
+
+// Lazily evaluated vector expressions. `lazy(a) + b - c * 2.` builds a tree of
+// lightweight nodes and the whole chain is computed in a single loop when it
+// is assigned or reduced, so no temporary vector is allocated per operator.
+// Expressions keep references to their operands: evaluate them before the
+// operand vectors go out of scope.
+//
+// `Assign(v, expr)` evaluates into an existing vector and reuses its storage;
+// `Eval(expr)` returns a new one. The conversion to std::vector is explicit:
+// std::vector::operator= cannot be overloaded from outside the class, so an
+// implicit `v = expr` would always build and move in a fresh vector.
+
+template<typename Derived>
+struct VectorExpr {
+    const Derived& self() const {
+        return static_cast<const Derived&>(*this);
+    }
+
+    template<typename Tp, typename Alloc>
+    explicit operator std::vector<Tp, Alloc>() const {
+        std::vector<Tp, Alloc> res;
+        Assign(res, self());
+        return res;
+    }
+};
+
+template<typename Expr>
+struct IsVectorExpr: std::is_base_of<VectorExpr<Expr>, Expr> {};
+
+template<typename Tp>
+class VectorRef: public VectorExpr<VectorRef<Tp>> {
+public:
+    using value_type = Tp;
+
+    template<typename Alloc>
+    explicit VectorRef(const std::vector<Tp, Alloc>& vec): data_(vec.data()), size_(vec.size()) {
+
+    }
+
+    explicit VectorRef(Span<const Tp> span): data_(span.data()), size_(span.size()) {
+
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    Tp operator[](size_t i) const {
+        return data_[i];
+    }
+
+private:
+    const Tp* data_;
+    size_t size_;
+};
+
+template<typename Arg, typename Op>
+class UnaryExpr: public VectorExpr<UnaryExpr<Arg, Op>> {
+public:
+    using value_type = typename Arg::value_type;
+
+    explicit UnaryExpr(const Arg& arg): arg_(arg) {
+
+    }
+
+    size_t size() const {
+        return arg_.size();
+    }
+
+    value_type operator[](size_t i) const {
+        return Op()(arg_[i]);
+    }
+
+private:
+    Arg arg_;
+};
+
+template<typename Left, typename Right, typename Op>
+class BinaryExpr: public VectorExpr<BinaryExpr<Left, Right, Op>> {
+public:
+    using value_type = typename Left::value_type;
+
+    BinaryExpr(const Left& left, const Right& right): left_(left), right_(right) {
+        assert(left_.size() == right_.size());
+    }
+
+    size_t size() const {
+        return left_.size();
+    }
+
+    value_type operator[](size_t i) const {
+        return Op()(left_[i], right_[i]);
+    }
+
+private:
+    Left left_;
+    Right right_;
+};
+
+template<typename Arg>
+class ScaleExpr: public VectorExpr<ScaleExpr<Arg>> {
+public:
+    using value_type = typename Arg::value_type;
+
+    ScaleExpr(const Arg& arg, value_type scalar): arg_(arg), scalar_(scalar) {
+
+    }
+
+    size_t size() const {
+        return arg_.size();
+    }
+
+    value_type operator[](size_t i) const {
+        return arg_[i] * scalar_;
+    }
+
+private:
+    Arg arg_;
+    value_type scalar_;
+};
+
+template<typename Tp, typename Alloc>
+auto lazy(const std::vector<Tp, Alloc>& vec) {
+    return VectorRef<Tp>(vec);
+}
+
+template<typename Tp>
+auto lazy(Span<Tp> span) {
+    return VectorRef<std::remove_cv_t<Tp>>(span);
+}
+
+template<typename Expr>
+const Expr& AsExpr(const VectorExpr<Expr>& expr) {
+    return expr.self();
+}
+
+// Any allocator, like IsStdVector below: a vector operand is only read.
+template<typename Tp, typename Alloc>
+auto AsExpr(const std::vector<Tp, Alloc>& vec) {
+    return VectorRef<Tp>(vec);
+}
+
+template<typename Tp>
+struct IsStdVector: std::false_type {};
+
+template<typename Tp, typename Alloc>
+struct IsStdVector<std::vector<Tp, Alloc>>: std::true_type {};
+
+template<typename Operand>
+constexpr bool IsExprOperand = IsVectorExpr<Operand>::value or IsStdVector<Operand>::value;
+
+// At least one side has to be an expression, otherwise the eager operators
+// from vector_ops.h are the ones that apply.
+template<typename Left, typename Right>
+using EnableIfExprOperands = std::enable_if_t<
+    IsExprOperand<Left> and IsExprOperand<Right> and
+    (IsVectorExpr<Left>::value or IsVectorExpr<Right>::value)>;
+
+template<typename Op, typename Left, typename Right>
+auto MakeBinaryExpr(const Left& left, const Right& right) {
+    auto l = AsExpr(left);
+    auto r = AsExpr(right);
+    return BinaryExpr<decltype(l), decltype(r), Op>(l, r);
+}
+
+template<typename Expr>
+auto operator+(const VectorExpr<Expr>& expr) {
+    return expr.self();
+}
+
+template<typename Expr>
+auto operator-(const VectorExpr<Expr>& expr) {
+    return UnaryExpr<Expr, std::negate<typename Expr::value_type>>(expr.self());
+}
+
+template<typename Left, typename Right, typename = EnableIfExprOperands<Left, Right>>
+auto operator+(const Left& left, const Right& right) {
+    using Tp = typename std::decay_t<decltype(AsExpr(left))>::value_type;
+    return MakeBinaryExpr<std::plus<Tp>>(left, right);
+}
+
+template<typename Left, typename Right, typename = EnableIfExprOperands<Left, Right>>
+auto operator-(const Left& left, const Right& right) {
+    using Tp = typename std::decay_t<decltype(AsExpr(left))>::value_type;
+    return MakeBinaryExpr<std::minus<Tp>>(left, right);
+}
+
+template<typename Left, typename Right, typename = EnableIfExprOperands<Left, Right>>
+auto operator|(const Left& left, const Right& right) {
+    using Tp = typename std::decay_t<decltype(AsExpr(left))>::value_type;
+    return MakeBinaryExpr<std::bit_or<Tp>>(left, right);
+}
+
+template<typename Left, typename Right, typename = EnableIfExprOperands<Left, Right>>
+auto operator&(const Left& left, const Right& right) {
+    using Tp = typename std::decay_t<decltype(AsExpr(left))>::value_type;
+    return MakeBinaryExpr<std::bit_and<Tp>>(left, right);
+}
+
+template<typename Expr, typename Scalar, typename = std::enable_if_t<std::is_arithmetic<Scalar>::value>>
+auto operator*(const VectorExpr<Expr>& expr, Scalar scalar) {
+    return ScaleExpr<Expr>(expr.self(), scalar);
+}
+
+template<typename Expr, typename Scalar, typename = std::enable_if_t<std::is_arithmetic<Scalar>::value>>
+auto operator*(Scalar scalar, const VectorExpr<Expr>& expr) {
+    return ScaleExpr<Expr>(expr.self(), scalar);
+}
+
+// Evaluates `expr` into `dest`, reusing its storage when the size matches.
+template<typename Tp, typename Alloc, typename Expr>
+void Assign(std::vector<Tp, Alloc>& dest, const VectorExpr<Expr>& expr) {
+    const auto& e = expr.self();
+    auto size = e.size();
+    dest.resize(size);
+
+    auto out = dest.data();
+    for (size_t i = 0; i < size; ++i)
+        out[i] = e[i];
+}
+
+// Compound assignment from an expression, e.g. `y += lazy(x) * alpha`, runs
+// in place without materializing the right-hand side.
+template<typename Tp, typename Expr, typename Op>
+auto& InplaceExprOp(std::vector<Tp>& dest, const VectorExpr<Expr>& expr, Op op) {
+    const auto& e = expr.self();
+    auto size = dest.size();
+    assert(size == e.size());
+
+    auto out = dest.data();
+    for (size_t i = 0; i < size; ++i)
+        out[i] = op(out[i], e[i]);
+
+    return dest;
+}
+
+template<typename Tp, typename Expr>
+auto& operator+=(std::vector<Tp>& dest, const VectorExpr<Expr>& expr) {
+    return InplaceExprOp(dest, expr, std::plus<Tp>());
+}
+
+template<typename Tp, typename Expr>
+auto& operator-=(std::vector<Tp>& dest, const VectorExpr<Expr>& expr) {
+    return InplaceExprOp(dest, expr, std::minus<Tp>());
+}
+
+template<typename Tp, typename Expr>
+auto& operator|=(std::vector<Tp>& dest, const VectorExpr<Expr>& expr) {
+    return InplaceExprOp(dest, expr, std::bit_or<Tp>());
+}
+
+template<typename Tp, typename Expr>
+auto& operator&=(std::vector<Tp>& dest, const VectorExpr<Expr>& expr) {
+    return InplaceExprOp(dest, expr, std::bit_and<Tp>());
+}
+
+template<typename Expr>
+auto Eval(const VectorExpr<Expr>& expr) {
+    std::vector<typename Expr::value_type> res;
+    Assign(res, expr);
+    return res;
+}
+
+template<typename Expr>
+auto Sum(const VectorExpr<Expr>& expr) {
+    const auto& e = expr.self();
+    auto size = e.size();
+
+    typename Expr::value_type res{};
+    for (size_t i = 0; i < size; ++i)
+        res += e[i];
+
+    return res;
+}
+
+// Dot product of two operands, at least one of them lazy, fused with their
+// element-wise computation like the eager `operator*` of vector_ops.h.
+template<typename Left, typename Right, typename = EnableIfExprOperands<Left, Right>>
+auto operator*(const Left& left, const Right& right) {
+    auto l = AsExpr(left);
+    auto r = AsExpr(right);
+    auto size = l.size();
+    assert(size == r.size());
+
+    typename std::decay_t<decltype(l)>::value_type res{};
+    for (size_t i = 0; i < size; ++i)
+        res += l[i] * r[i];
+
+    return res;
+}
+
+}  // namespace task
@@ -0,0 +1,386 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "span.h"
+
+namespace task {
+
+class VectorFormatException: public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Binary framed format. Every vector is a 16-byte header followed by its raw
+// elements, padded to a multiple of 8 bytes so that the data of each frame in
+// a memory-mapped file is suitably aligned:
+//
+//   "TVEC" | uint16 version | uint8 kind | uint8 element size | uint64 count
+//
+// Values are stored in host byte order.
+struct FrameHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t kind;
+    uint8_t element_size;
+    uint64_t count;
+};
+
+static_assert(sizeof(FrameHeader) == 16, "unexpected FrameHeader padding");
+
+constexpr char kFrameMagic[4] = {'T', 'V', 'E', 'C'};
+constexpr uint16_t kFrameVersion = 1;
+
+enum class ElementKind: uint8_t {
+    kSigned = 0,
+    kUnsigned = 1,
+    kFloating = 2,
+};
+
+template<typename Tp>
+constexpr ElementKind KindOf() {
+    static_assert(std::is_arithmetic<Tp>::value, "only arithmetic elements have a binary form");
+    return std::is_floating_point<Tp>::value ? ElementKind::kFloating :
+           std::is_signed<Tp>::value ? ElementKind::kSigned : ElementKind::kUnsigned;
+}
+
+template<typename Tp>
+FrameHeader MakeFrameHeader(size_t count) {
+    FrameHeader header{};
+    std::memcpy(header.magic, kFrameMagic, sizeof(kFrameMagic));
+    header.version = kFrameVersion;
+    header.kind = static_cast<uint8_t>(KindOf<Tp>());
+    header.element_size = sizeof(Tp);
+    header.count = count;
+    return header;
+}
+
+template<typename Tp>
+bool Matches(const FrameHeader& header) {
+    return std::memcmp(header.magic, kFrameMagic, sizeof(kFrameMagic)) == 0 and
+           header.version == kFrameVersion and header.kind == static_cast<uint8_t>(KindOf<Tp>()) and
+           header.element_size == sizeof(Tp);
+}
+
+inline size_t FramePadding(size_t bytes) {
+    return (8 - bytes % 8) % 8;
+}
+
+template<typename Tp>
+std::ostream& WriteBinary(std::ostream& out, Span<Tp> source) {
+    using Value = std::remove_cv_t<Tp>;
+    auto header = MakeFrameHeader<Value>(source.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    auto bytes = source.size() * sizeof(Value);
+    out.write(reinterpret_cast<const char*>(source.data()), bytes);
+
+    const char zeros[8] = {};
+    out.write(zeros, FramePadding(bytes));
+
+    return out;
+}
+
+template<typename Tp>
+std::ostream& WriteBinary(std::ostream& out, const std::vector<Tp>& source) {
+    return WriteBinary(out, Span<const Tp>(source));
+}
+
+// Reads one frame into `dest`; sets failbit on a malformed or mismatching
+// header or on a short read, leaving `dest` untouched. The values are read
+// in bounded chunks as they arrive, so a corrupt count cannot force a large
+// allocation before the data backs it up.
+template<typename Tp>
+std::istream& ReadBinary(std::istream& in, std::vector<Tp>& dest) {
+    constexpr size_t kChunk = (1 << 20) / sizeof(Tp);
+
+    FrameHeader header;
+    if (not in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return in;
+
+    if (not Matches<Tp>(header) or header.count > SIZE_MAX / sizeof(Tp)) {
+        in.setstate(std::ios::failbit);
+        return in;
+    }
+
+    size_t count = header.count;
+    std::vector<Tp> res;
+    while (res.size() < count) {
+        auto done = res.size();
+        auto step = std::min(kChunk, count - done);
+        res.resize(done + step);
+        if (not in.read(reinterpret_cast<char*>(res.data() + done), step * sizeof(Tp)))
+            return in;
+    }
+
+    char padding[8];
+    if (in.read(padding, FramePadding(count * sizeof(Tp))))
+        dest.swap(res);
+
+    return in;
+}
+
+// Read-only memory mapping of a file of consecutive binary frames. Frames
+// are exposed as spans straight into the mapping, without copying.
+class MappedVectorFile {
+public:
+    explicit MappedVectorFile(const std::string& path): data_(nullptr), size_(0) {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw VectorFormatException("cannot open " + path);
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw VectorFormatException("cannot stat " + path);
+        }
+
+        size_ = info.st_size;
+        if (size_ != 0) {
+            auto mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw VectorFormatException("cannot map " + path);
+            }
+            data_ = static_cast<const char*>(mapped);
+            ::madvise(mapped, size_, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+
+        try {
+            Index();
+        } catch (...) {
+            Unmap();
+            throw;
+        }
+    }
+
+    MappedVectorFile(const MappedVectorFile&) = delete;
+    MappedVectorFile& operator=(const MappedVectorFile&) = delete;
+
+    MappedVectorFile(MappedVectorFile&& other):
+        data_(other.data_), size_(other.size_), frames_(std::move(other.frames_)) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    ~MappedVectorFile() {
+        Unmap();
+    }
+
+    size_t size() const {
+        return frames_.size();
+    }
+
+    const FrameHeader& header(size_t i) const {
+        return *reinterpret_cast<const FrameHeader*>(data_ + frames_[i]);
+    }
+
+    template<typename Tp>
+    Span<const Tp> Get(size_t i) const {
+        const auto& frame = header(i);
+        if (not Matches<Tp>(frame))
+            throw VectorFormatException("frame element type mismatch");
+
+        auto values = reinterpret_cast<const Tp*>(data_ + frames_[i] + sizeof(FrameHeader));
+        return {values, static_cast<size_t>(frame.count)};
+    }
+
+private:
+    void Index() {
+        size_t offset = 0;
+        while (offset < size_) {
+            if (size_ - offset < sizeof(FrameHeader))
+                throw VectorFormatException("truncated frame header");
+
+            FrameHeader frame;
+            std::memcpy(&frame, data_ + offset, sizeof(frame));
+            if (std::memcmp(frame.magic, kFrameMagic, sizeof(kFrameMagic)) != 0 or frame.version != kFrameVersion)
+                throw VectorFormatException("not a vector frame");
+
+            auto bytes = frame.count * frame.element_size;
+            if (frame.element_size == 0 or frame.count > (size_ - offset) / frame.element_size)
+                throw VectorFormatException("truncated frame data");
+            auto end = offset + sizeof(FrameHeader) + bytes + FramePadding(bytes);
+            if (end > size_)
+                throw VectorFormatException("truncated frame data");
+
+            frames_.push_back(offset);
+            offset = end;
+        }
+    }
+
+    void Unmap() {
+        if (data_)
+            ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+
+    const char* data_;
+    size_t size_;
+    std::vector<size_t> frames_;
+};
+
+// Text format of the stream operators: the element count, then the values.
+// Formatting uses std::to_chars, which prints the shortest representation
+// that parses back to the same value, and parsing uses std::from_chars;
+// neither goes through locales or per-element stream sentries.
+
+// Appends the values separated by spaces and followed by a newline, as
+// `operator<<` does.
+template<typename Tp>
+void FormatText(Span<Tp> source, std::string& buffer) {
+    constexpr size_t kMaxChars = 32;
+    auto size = source.size();
+    auto used = buffer.size();
+    buffer.resize(used + size * kMaxChars);
+
+    auto first = &buffer[0] + used;
+    auto last = &buffer[0] + buffer.size();
+    for (size_t i = 0; i < size; ++i) {
+        first = std::to_chars(first, last, source[i]).ptr;
+        *first++ = i == size - 1 ? '\n' : ' ';
+    }
+
+    buffer.resize(first - &buffer[0]);
+}
+
+template<typename Tp>
+void FormatText(const std::vector<Tp>& source, std::string& buffer) {
+    FormatText(Span<const Tp>(source), buffer);
+}
+
+// Writes the values of `source` as `operator<<` does, formatting them into a
+// large buffer that goes to the stream in a few big writes.
+template<typename Tp>
+std::ostream& WriteText(std::ostream& out, const std::vector<Tp>& source) {
+    constexpr size_t kBlock = 1 << 14;
+    std::string buffer;
+    for (size_t begin = 0; begin < source.size(); begin += kBlock) {
+        buffer.clear();
+        auto count = std::min(kBlock, source.size() - begin);
+        FormatText(Span<const Tp>(source.data() + begin, count), buffer);
+        if (begin + count < source.size())
+            buffer.back() = ' ';
+        out.write(buffer.data(), buffer.size());
+    }
+
+    return out;
+}
+
+inline bool IsSpace(char c) {
+    return c == ' ' or c == '\n' or c == '\t' or c == '\r' or c == '\v' or c == '\f';
+}
+
+inline const char* SkipSpaces(const char* first, const char* last) {
+    while (first != last and IsSpace(*first))
+        ++first;
+    return first;
+}
+
+// Values of a text frame are stored in chunks of this many bytes as they
+// parse, so a corrupt count cannot force a large allocation up front.
+constexpr size_t kTextChunk = 1 << 20;
+
+// Parses a count followed by that many values from [first, last). Returns the
+// position right after the last value, or nullptr on malformed input.
+template<typename Tp>
+const char* ParseText(const char* first, const char* last, std::vector<Tp>& dest) {
+    constexpr size_t kChunk = kTextChunk / sizeof(Tp);
+
+    size_t n;
+    auto res = std::from_chars(SkipSpaces(first, last), last, n);
+    if (res.ec != std::errc())
+        return nullptr;
+
+    std::vector<Tp> values;
+    first = res.ptr;
+    while (values.size() < n) {
+        auto done = values.size();
+        values.resize(done + std::min(kChunk, n - done));
+        for (auto i = done; i < values.size(); ++i) {
+            res = std::from_chars(SkipSpaces(first, last), last, values[i]);
+            if (res.ec != std::errc())
+                return nullptr;
+            first = res.ptr;
+        }
+    }
+
+    dest.swap(values);
+    return first;
+}
+
+// Reads the next whitespace-delimited token straight from the stream buffer.
+inline bool ReadToken(std::streambuf* buf, char* token, size_t capacity, size_t& length) {
+    using Traits = std::streambuf::traits_type;
+    auto c = buf->sgetc();
+    while (c != Traits::eof() and IsSpace(Traits::to_char_type(c)))
+        c = buf->snextc();
+
+    length = 0;
+    while (c != Traits::eof() and not IsSpace(Traits::to_char_type(c))) {
+        if (length == capacity)
+            return false;
+        token[length++] = Traits::to_char_type(c);
+        c = buf->snextc();
+    }
+
+    return length != 0;
+}
+
+// Stream counterpart of ParseText with the semantics of `operator>>`: it
+// consumes exactly the count and the values, so frames can follow each other
+// in one stream. Sets failbit on malformed input; like ParseText, it stores
+// the values in bounded chunks.
+template<typename Tp>
+std::istream& ReadText(std::istream& in, std::vector<Tp>& dest) {
+    constexpr size_t kChunk = kTextChunk / sizeof(Tp);
+
+    std::istream::sentry sentry(in);
+    if (not sentry)
+        return in;
+
+    auto buf = in.rdbuf();
+    char token[128];
+    size_t length;
+
+    auto parse = [&](auto& value) {
+        return ReadToken(buf, token, sizeof(token), length) and
+               std::from_chars(token, token + length, value).ptr == token + length;
+    };
+
+    size_t n;
+    if (not parse(n)) {
+        in.setstate(std::ios::failbit);
+        return in;
+    }
+
+    std::vector<Tp> values;
+    while (values.size() < n) {
+        auto done = values.size();
+        values.resize(done + std::min(kChunk, n - done));
+        for (auto i = done; i < values.size(); ++i) {
+            if (not parse(values[i])) {
+                in.setstate(std::ios::failbit);
+                return in;
+            }
+        }
+    }
+
+    dest.swap(values);
+    return in;
+}
+
+}  // namespace task
@@ -2,65 +2,119 @@
 #include <vector>
 #include <iostream>
 #include <cassert>
-#include <numeric>
+#include <cmath>
+#include <limits>
 #include <algorithm>
+#include <type_traits>
+
+#include "parallel.h"
+#include "span.h"
 
 namespace task {
 
-template<typename Tp> auto operator+(const std::vector<Tp>& vec) {
-    return vec;
-}
+// Kernels over spans of contiguous memory. The std::vector operators below are
+// thin wrappers around them, and the same loops apply to slices, Matrix rows
+// or mapped files. Inputs are Span<const Tp>; Tp is deduced from the output
+// span, so vectors and mutable spans convert to the input type implicitly.
 
-template<typename Tp> auto operator-(const std::vector<Tp>& vec) {
-    auto res = decltype(vec){};
-    res.reserve(vec.size());
-    std::transform(std::begin(vec), std::end(vec), std::back_inserter(res), std::negate<Tp>());
+// out[i] = op(left[i], right[i]); `out` may alias either input.
+template<typename Tp, typename Op>
+void Transform(NonDeduced<Span<const Tp>> left, NonDeduced<Span<const Tp>> right, Span<Tp> out, Op op) {
+    auto size = left.size();
+    assert(size == right.size() and size == out.size());
 
-    return res;
+    auto l = left.data();
+    auto r = right.data();
+    auto o = out.data();
+    for (size_t i = 0; i < size; ++i)
+        o[i] = op(l[i], r[i]);
 }
 
-template<typename Tp, typename Op> auto
-BinaryOp(const std::vector<Tp>& left, const std::vector<Tp>& right, Op op) {
-    auto size = left.size();
-    assert(size == right.size());
-
-    auto res = decltype(left){};
-    res.reserve(size);
+template<typename Tp>
+void Negate(NonDeduced<Span<const Tp>> source, Span<Tp> out) {
+    auto size = source.size();
+    assert(size == out.size());
 
-    std::transform(std::begin(left), std::end(left), std::begin(right),
-        std::back_inserter(res), op);
+    auto s = source.data();
+    auto o = out.data();
+    for (size_t i = 0; i < size; ++i)
+        o[i] = -s[i];
+}
 
-    return res;
+// Applies `op` element-wise and stores the result into `left`, which may alias
+// `right`.
+template<typename Tp, typename Op>
+void InplaceOp(Span<Tp> left, NonDeduced<Span<const Tp>> right, Op op) {
+    Transform<Tp>(left, right, left, op);
 }
 
 template<typename Tp>
-auto operator+(const std::vector<Tp>& left, const std::vector<Tp>& right) {
-    return BinaryOp(left, right, std::plus<Tp>());
+void Scale(Span<Tp> vec, const NonDeduced<Tp>& scalar) {
+    auto size = vec.size();
+    auto v = vec.data();
+    for (size_t i = 0; i < size; ++i)
+        v[i] *= scalar;
 }
 
+// y += alpha * x in a single pass over the existing storage of `y`.
 template<typename Tp>
-auto operator-(const std::vector<Tp>& left, const std::vector<Tp>& right) {
-    return BinaryOp(left, right, std::minus<Tp>());
+void Axpy(const NonDeduced<Tp>& alpha, NonDeduced<Span<const Tp>> x, Span<Tp> y) {
+    auto size = y.size();
+    assert(size == x.size());
+
+    auto xs = x.data();
+    auto ys = y.data();
+    for (size_t i = 0; i < size; ++i)
+        ys[i] += alpha * xs[i];
 }
 
+// Dot product over raw memory. Four independent accumulators break the
+// dependency chain of a single running sum, so the loop maps onto SIMD lanes
+// without relying on -ffast-math.
 template<typename Tp>
-auto operator*(const std::vector<Tp>& left, const std::vector<Tp>& right) {
-    auto res = BinaryOp(left, right, std::multiplies<Tp>());
-    return std::accumulate(std::begin(res), std::end(res), Tp{});
+Tp Dot(const Tp* left, const Tp* right, size_t size) {
+    Tp acc[4] = {};
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        acc[0] += left[i] * right[i];
+        acc[1] += left[i + 1] * right[i + 1];
+        acc[2] += left[i + 2] * right[i + 2];
+        acc[3] += left[i + 3] * right[i + 3];
+    }
+    for (; i < size; ++i)
+        acc[0] += left[i] * right[i];
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
 }
 
-template<typename Tp>
-auto operator%(const std::vector<Tp>& left, const std::vector<Tp>& right) {
-    assert(left.size() == 3 and right.size() == 3);
-    return decltype(left) {left[1] * right[2] - left[2] * right[1], left[2] * right[0] - left[0] * right[2],
-                           left[0] * right[1] - left[1] * right[0]};
+template<typename Left, typename Right>
+auto Dot(Span<Left> left, Span<Right> right) {
+    static_assert(std::is_same<std::remove_cv_t<Left>, std::remove_cv_t<Right>>::value, "element types differ");
+    assert(left.size() == right.size());
+    return Dot<std::remove_cv_t<Left>>(left.data(), right.data(), left.size());
 }
 
 template<typename Tp>
-auto operator||(const std::vector<Tp>& left, const std::vector<Tp>& right) {
+void Cross(NonDeduced<Span<const Tp>> left, NonDeduced<Span<const Tp>> right, Span<Tp> out) {
+    assert(left.size() == 3 and right.size() == 3 and out.size() == 3);
+    Tp res[3] = {left[1] * right[2] - left[2] * right[1], left[2] * right[0] - left[0] * right[2],
+                 left[0] * right[1] - left[1] * right[0]};
+    std::copy(res, res + 3, out.begin());
+}
+
+// 1 for codirected, -1 for opposite, 0 for non-collinear vectors. Elements
+// are compared with an absolute tolerance of 1e-4, so the result depends on
+// the scale of the vectors: components below 1e-4 count as zero. CollinearFlag,
+// used by Vec and the batched checks, bounds the angle instead; the two agree
+// on exact multiples but may differ for nearly collinear or tiny vectors.
+template<typename Left, typename Right>
+int Collinear(Span<Left> left, Span<Right> right) {
+    using Tp = std::remove_cv_t<Left>;
+    static_assert(std::is_same<Tp, std::remove_cv_t<Right>>::value, "element types differ");
+
     constexpr Tp zero = {};
     constexpr Tp eps = Tp{0.0001f};
-    static auto is_close = [eps](Tp x, Tp y){return abs(x - y) <= eps;};
+    static auto is_close = [eps](Tp x, Tp y){return std::abs(x - y) <= eps;};
 
     auto size = left.size();
     assert(size == right.size());
@@ -87,6 +141,153 @@ auto operator||(const std::vector<Tp>& left, const std::vector<Tp>& right) {
     return ratio >= zero ? 1 : -1;
 }
 
+// The square root of the machine epsilon leaves room for the rounding of dot
+// products on long vectors.
+template<typename Tp>
+Tp DefaultCollinearTolerance() {
+    return std::sqrt(std::numeric_limits<Tp>::epsilon());
+}
+
+// Collinearity flag in the `operator||` encoding computed from the dot product
+// and the squared norms of two vectors: |u|^2 |v|^2 - (u, v)^2 is the squared
+// norm of their cross product, so comparing it with `tolerance` times the
+// product of the norms bounds the squared sine of the angle between them.
+// A zero vector is collinear only with another zero vector.
+//
+// This relative test is scale-invariant, unlike the absolute per-element
+// tolerance of Collinear and the std::vector `operator||`; near the threshold
+// the two can give different answers for the same pair.
+template<typename Tp>
+int CollinearFlag(Tp dot, Tp left_norm2, Tp right_norm2, Tp tolerance) {
+    auto norms = left_norm2 * right_norm2;
+    int collinear = (norms - dot * dot <= tolerance * norms) & ((left_norm2 > Tp{}) == (right_norm2 > Tp{}));
+    return collinear * (1 - 2 * (dot < Tp{}));
+}
+
+// Work per thread below which the parallel paths fall back to one thread.
+constexpr size_t kParallelChunk = 1 << 16;
+
+// Swaps the elements at mirrored positions i and size - 1 - i for i in
+// [begin, end). The front block is walked forwards and the back block
+// backwards, a pattern the compiler turns into vector loads plus lane
+// shuffles for trivially copyable types.
+template<typename Tp>
+void ReverseRange(Tp* data, size_t size, size_t begin, size_t end) {
+    constexpr size_t kBlock = 256;
+    for (size_t i = begin; i < end; i += kBlock) {
+        auto count = std::min(kBlock, end - i);
+        auto front = data + i;
+        auto back = data + size - i - count;
+        for (size_t k = 0; k < count; ++k)
+            std::swap(front[k], back[count - 1 - k]);
+    }
+}
+
+template<typename Tp>
+void reverse(Span<Tp> vec, size_t threads = DefaultThreadCount()) {
+    auto size = vec.size();
+    auto data = vec.data();
+    ParallelFor(size / 2, [data, size](size_t begin, size_t end) {
+        ReverseRange(data, size, begin, end);
+    }, threads, kParallelChunk);
+}
+
+// Software prefetch distance for the random side of gather and scatter.
+constexpr size_t kPrefetchDistance = 16;
+
+// out[i] = source[indices[i]]. Output blocks are split between threads and
+// the random reads are prefetched a few iterations ahead.
+template<typename Tp>
+void Gather(NonDeduced<Span<const Tp>> source, Span<const size_t> indices, Span<Tp> out,
+            size_t threads = DefaultThreadCount()) {
+    assert(indices.size() == out.size());
+
+    auto src = source.data();
+    auto idx = indices.data();
+    auto dest = out.data();
+    ParallelFor(indices.size(), [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (i + kPrefetchDistance < end)
+                __builtin_prefetch(src + idx[i + kPrefetchDistance]);
+            assert(idx[i] < source.size());
+            dest[i] = src[idx[i]];
+        }
+    }, threads, kParallelChunk);
+}
+
+// dest[indices[i]] = source[i]. Indices must not repeat, which lets threads
+// write disjoint elements of `dest` without synchronization.
+template<typename Tp>
+void Scatter(NonDeduced<Span<const Tp>> source, Span<const size_t> indices, Span<Tp> dest,
+             size_t threads = DefaultThreadCount()) {
+    assert(source.size() == indices.size());
+
+    auto src = source.data();
+    auto idx = indices.data();
+    auto out = dest.data();
+    ParallelFor(source.size(), [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (i + kPrefetchDistance < end)
+                __builtin_prefetch(out + idx[i + kPrefetchDistance], 1);
+            assert(idx[i] < dest.size());
+            out[idx[i]] = src[i];
+        }
+    }, threads, kParallelChunk);
+}
+
+template<typename Tp> auto operator+(const std::vector<Tp>& vec) {
+    return vec;
+}
+
+template<typename Tp> auto operator-(const std::vector<Tp>& vec) {
+    std::vector<Tp> res(vec.size());
+    Negate<Tp>(vec, res);
+
+    return res;
+}
+
+template<typename Tp, typename Op> auto
+BinaryOp(const std::vector<Tp>& left, const std::vector<Tp>& right, Op op) {
+    std::vector<Tp> res(left.size());
+    Transform<Tp>(left, right, res, op);
+
+    return res;
+}
+
+template<typename Tp, typename Op> auto&
+InplaceOp(std::vector<Tp>& left, const std::vector<Tp>& right, Op op) {
+    InplaceOp(Span<Tp>(left), Span<const Tp>(right), op);
+    return left;
+}
+
+template<typename Tp>
+auto operator+(const std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return BinaryOp(left, right, std::plus<Tp>());
+}
+
+template<typename Tp>
+auto operator-(const std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return BinaryOp(left, right, std::minus<Tp>());
+}
+
+template<typename Tp>
+auto operator*(const std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return Dot(Span<const Tp>(left), Span<const Tp>(right));
+}
+
+template<typename Tp>
+auto operator%(const std::vector<Tp>& left, const std::vector<Tp>& right) {
+    std::vector<Tp> res(3);
+    Cross<Tp>(left, right, res);
+    return res;
+}
+
+// Per-element test of Collinear, with its absolute tolerance.
+template<typename Tp>
+auto operator||(const std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return Collinear(Span<const Tp>(left), Span<const Tp>(right));
+}
+
 template<typename Tp>
 auto operator&&(const std::vector<Tp>& left, const std::vector<Tp>& right) {
     return (left || right) == 1;
@@ -114,11 +315,30 @@ std::ostream& operator<<(std::ostream& out, const std::vector<Tp>& source) {
 }
 
 template<typename Tp>
-auto reverse(std::vector<Tp>& vec) {
-    auto begin = std::begin(vec), end = std::end(vec);
-    while (std::distance(begin, end) > 1) {
-        std::iter_swap(begin++, --end);
-    }
+auto reverse(std::vector<Tp>& vec, size_t threads = DefaultThreadCount()) {
+    reverse(Span<Tp>(vec), threads);
+}
+
+template<typename Tp>
+auto Gather(const std::vector<Tp>& source, const std::vector<size_t>& indices,
+            size_t threads = DefaultThreadCount()) {
+    std::vector<Tp> res(indices.size());
+    Gather(Span<const Tp>(source), Span<const size_t>(indices), Span<Tp>(res), threads);
+    return res;
+}
+
+template<typename Tp>
+void Scatter(const std::vector<Tp>& source, const std::vector<size_t>& indices, std::vector<Tp>& dest,
+             size_t threads = DefaultThreadCount()) {
+    Scatter(Span<const Tp>(source), Span<const size_t>(indices), Span<Tp>(dest), threads);
+}
+
+// Reorders `vec` so that its i-th element becomes the old vec[permutation[i]].
+template<typename Tp>
+void permute(std::vector<Tp>& vec, const std::vector<size_t>& permutation, size_t threads = DefaultThreadCount()) {
+    assert(vec.size() == permutation.size());
+    auto res = Gather(vec, permutation, threads);
+    vec.swap(res);
 }
 
 template<typename Tp>
@@ -131,4 +351,36 @@ auto operator&(const std::vector<Tp>& left, const std::vector<Tp>& right) {
     return BinaryOp(left, right, std::bit_and<Tp>());
 }
 
-}  // namespace task
+template<typename Tp>
+auto& operator+=(std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return InplaceOp(left, right, std::plus<Tp>());
+}
+
+template<typename Tp>
+auto& operator-=(std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return InplaceOp(left, right, std::minus<Tp>());
+}
+
+template<typename Tp>
+auto& operator*=(std::vector<Tp>& vec, const typename std::vector<Tp>::value_type& scalar) {
+    Scale<Tp>(vec, scalar);
+    return vec;
+}
+
+template<typename Tp>
+auto& operator|=(std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return InplaceOp(left, right, std::bit_or<Tp>());
+}
+
+template<typename Tp>
+auto& operator&=(std::vector<Tp>& left, const std::vector<Tp>& right) {
+    return InplaceOp(left, right, std::bit_and<Tp>());
+}
+
+template<typename Tp>
+auto& Axpy(const typename std::vector<Tp>::value_type& alpha, const std::vector<Tp>& x, std::vector<Tp>& y) {
+    Axpy(alpha, Span<const Tp>(x), Span<Tp>(y));
+    return y;
+}
+
+}  // namespace task
\ No newline at end of file
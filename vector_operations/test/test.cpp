@@ -2,11 +2,22 @@
 #include <string>
 #include <random>
 #include <algorithm>
+#include <numeric>
 #include <vector>
 #include <valarray>
 #include <sstream>
 #include <cmath>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
 #include "src/vector_ops.h"
+#include "src/vector_expr.h"
+#include "src/vector_batch.h"
+#include "src/small_vec.h"
+#include "src/bit_vector.h"
+#include "src/vector_io.h"
+#include "src/reductions.h"
+#include "src/ann_index.h"
 
 
 using namespace task;
@@ -74,6 +85,37 @@ void FailWithMsg(const std::string& msg, int line) {
 const double EPS = 1e-7;
 
 
+// A stateless allocator that is not std::allocator, for vectors with a
+// custom allocator.
+template <class T>
+struct PlainAllocator {
+    using value_type = T;
+
+    PlainAllocator() = default;
+
+    template <class U>
+    PlainAllocator(const PlainAllocator<U>&) {
+
+    }
+
+    T* allocate(size_t count) {
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* ptr, size_t count) {
+        std::allocator<T>().deallocate(ptr, count);
+    }
+
+    bool operator==(const PlainAllocator&) const {
+        return true;
+    }
+
+    bool operator!=(const PlainAllocator&) const {
+        return false;
+    }
+};
+
+
 int main() {
 
     {
@@ -235,4 +277,490 @@ int main() {
         ASSERT_EQUAL_MSG(vec, vec2, "reverse")
     }
 
+    REPEAT(100)
+    {
+        std::vector<double> a, b, c;
+        RandomFillDouble(a, 1000);
+        RandomFillDouble(b, a.size());
+        RandomFillDouble(c, a.size());
+
+        auto res = Eval(lazy(a) + b - lazy(c) * 2.);
+        auto expected = a + b - (c + c);
+        for (size_t i = 0; i < a.size(); ++i) {
+            ASSERT_TRUE_MSG(fabs(res[i] - expected[i]) < EPS, "Lazy expression")
+        }
+
+        auto storage = res.data();
+        Assign(res, -(lazy(a) - b));
+        expected = -(a - b);
+        ASSERT_EQUAL_MSG(res, expected, "Lazy unary -")
+        ASSERT_TRUE_MSG(res.data() == storage, "Lazy assign reuses storage")
+
+        Assign(res, 0.5 * lazy(res));
+        expected = Eval(lazy(b) * 0.5 - lazy(a) * 0.5);
+        ASSERT_EQUAL_MSG(res, expected, "Lazy assign")
+
+        ASSERT_TRUE_MSG(fabs((lazy(a) + b) * c - (a + b) * c) < EPS, "Lazy dot product")
+        ASSERT_TRUE_MSG(fabs(Sum(lazy(a) - a)) < EPS, "Lazy sum")
+
+        std::vector<int> x, y, z;
+        RandomFill(x, 1000);
+        RandomFill(y, x.size());
+        RandomFill(z, x.size());
+
+        std::vector<int> bits((lazy(x) | y) & z);
+        auto expected_bits = (x | y) & z;
+        ASSERT_EQUAL_MSG(bits, expected_bits, "Lazy bitwise")
+
+        // Vectors with another allocator are operands too.
+        std::vector<int, PlainAllocator<int>> other_y(y.begin(), y.end());
+        std::vector<int, PlainAllocator<int>> other_bits((lazy(x) | other_y) & z);
+        ASSERT_EQUAL_MSG(other_bits, expected_bits, "Lazy expression over custom allocators")
+    }
+
+    REPEAT(100)
+    {
+        std::vector<double> a, b;
+        RandomFillDouble(a, 1000);
+        RandomFillDouble(b, a.size());
+
+        auto expected = a + b;
+        auto data = a.data();
+        a += b;
+        ASSERT_EQUAL_MSG(a, expected, "Compound +=")
+        ASSERT_TRUE_MSG(a.data() == data, "Compound += reallocated")
+
+        expected = a - b;
+        a -= b;
+        ASSERT_EQUAL_MSG(a, expected, "Compound -=")
+
+        auto alpha = RandomDouble();
+        expected = a;
+        for (auto& item : expected)
+            item *= alpha;
+        a *= alpha;
+        ASSERT_EQUAL_MSG(a, expected, "Compound *=")
+
+        expected = a;
+        for (size_t i = 0; i < a.size(); ++i)
+            expected[i] += alpha * b[i];
+        Axpy(alpha, b, a);
+        ASSERT_EQUAL_MSG(a, expected, "Axpy")
+
+        expected = a - b - b;
+        a -= lazy(b) * 2.;
+        for (size_t i = 0; i < a.size(); ++i) {
+            ASSERT_TRUE_MSG(fabs(a[i] - expected[i]) < EPS, "Compound -= expression")
+        }
+
+        std::vector<int> x, y;
+        RandomFill(x, 1000);
+        RandomFill(y, x.size());
+
+        auto expected_bits = (x | y) & y;
+        x |= y;
+        x &= y;
+        ASSERT_EQUAL_MSG(x, expected_bits, "Compound |= and &=")
+    }
+
+    REPEAT(10)
+    {
+        const size_t dim = 50, count = 200;
+        std::vector<double> query, block;
+        RandomFillDouble(query, dim);
+
+        for (size_t i = 0; i < count; ++i) {
+            std::vector<double> row;
+            switch (RandomUInt(2)) {
+                case 0:
+                    RandomFillDouble(row, dim);
+                    break;
+                case 1:
+                    row = query;
+                    row *= RandomDouble();
+                    break;
+                default:
+                    row.assign(dim, 0.);
+            }
+            block.insert(block.end(), row.begin(), row.end());
+        }
+
+        auto flags = Collinearity(query, block);
+        auto codirected = Codirectionality(query, block, DefaultCollinearTolerance<double>(), 3);
+        auto pairs = PairwiseCollinearity(block, dim, DefaultCollinearTolerance<double>(), 4);
+        ASSERT_TRUE(flags.size() == count && pairs.size() == count * count)
+
+        for (size_t i = 0; i < count; ++i) {
+            std::vector<double> row(block.begin() + i * dim, block.begin() + (i + 1) * dim);
+            ASSERT_TRUE_MSG(flags[i] == (query || row), "Batched collinearity")
+            ASSERT_TRUE_MSG(codirected[i] == (query && row), "Batched codirectionality")
+
+            for (size_t j = 0; j < count; j += 7) {
+                std::vector<double> other(block.begin() + j * dim, block.begin() + (j + 1) * dim);
+                ASSERT_TRUE_MSG(pairs[i * count + j] == (row || other), "Pairwise collinearity")
+            }
+        }
+    }
+
+    {
+        constexpr Vec<int, 3> x{{1, 0, 0}}, y{{0, 1, 0}};
+        static_assert(x % y == Vec<int, 3>{{0, 0, 1}}, "constexpr cross product");
+        static_assert(x * y == 0 && (x + y) * (x + y) == 2, "constexpr dot product");
+    }
+
+    REPEAT(100)
+    {
+        std::vector<double> vec, vec2;
+        RandomFillDouble(vec, 3);
+        RandomFillDouble(vec2, vec.size());
+
+        auto a = ToVec<3>(vec), b = ToVec<3>(vec2);
+        auto cross = ToVector(a % b);
+        auto expected = vec % vec2;
+        ASSERT_EQUAL_MSG(cross, expected, "Vec cross product")
+        ASSERT_TRUE_MSG(fabs(a * b - vec * vec2) < EPS, "Vec dot product")
+        ASSERT_TRUE_MSG(fabs(Norm(a) * Norm(a) - vec * vec) < EPS, "Vec norm")
+
+        auto diff = ToVector(a + b * 2. - -b);
+        expected = vec + vec2 + vec2 + vec2;
+        ASSERT_TRUE_MSG(fabs(Norm(ToVec<3>(diff - expected))) < EPS, "Vec arithmetic")
+
+        auto mult = RandomDouble();
+        ASSERT_TRUE_MSG((a || a * mult) == (mult > 0 ? 1 : -1), "Vec collinearity")
+        ASSERT_TRUE_MSG((a && a * mult) == (mult > 0), "Vec codirectionality")
+        ASSERT_TRUE_MSG(!(a || a % b), "Vec collinearity")
+
+        std::stringstream stream;
+        stream << a.size() << '\n' << a;
+        Vec<double, 3> c{};
+        stream >> c;
+        ASSERT_TRUE_MSG(stream && fabs(Norm(a - c)) < 1e-2, "Vec stream operators")
+    }
+
+    REPEAT(10)
+    {
+        std::vector<int> vec, vec2;
+        RandomFill(vec, RandomUInt(200'000, 300'000));
+        vec2 = vec;
+
+        reverse(vec, 4);
+        std::reverse(vec2.begin(), vec2.end());
+        ASSERT_EQUAL_MSG(vec, vec2, "Parallel reverse")
+
+        std::vector<size_t> perm(vec.size());
+        std::iota(perm.begin(), perm.end(), 0);
+        std::shuffle(perm.begin(), perm.end(), std::mt19937(RandomUInt()));
+
+        auto gathered = Gather(vec, perm, 3);
+        for (size_t i = 0; i < vec.size(); i += 97) {
+            ASSERT_TRUE_MSG(gathered[i] == vec[perm[i]], "Gather")
+        }
+
+        std::vector<int> scattered(vec.size());
+        Scatter(gathered, perm, scattered, 3);
+        ASSERT_EQUAL_MSG(scattered, vec, "Scatter")
+
+        permute(vec2, perm);
+        std::reverse(vec2.begin(), vec2.end());
+        reverse(gathered);
+        ASSERT_EQUAL_MSG(vec2, gathered, "permute")
+    }
+
+    REPEAT(100)
+    {
+        std::vector<int> vec, vec2;
+        RandomFill(vec, RandomUInt(1, 1000), 1);
+        RandomFill(vec2, vec.size(), 1);
+
+        BitVector bits(vec), bits2(vec2);
+        ASSERT_TRUE_MSG(bits.ToVector() == vec, "BitVector conversion")
+
+        auto expected = vec | vec2;
+        ASSERT_TRUE_MSG((bits | bits2).ToVector() == expected, "BitVector OR")
+        expected = vec & vec2;
+        ASSERT_TRUE_MSG((bits & bits2).ToVector() == expected, "BitVector AND")
+
+        size_t ones = 0, common = 0, united = 0, differ = 0, and_not = 0;
+        for (size_t i = 0; i < vec.size(); ++i) {
+            ones += vec[i];
+            common += vec[i] & vec2[i];
+            united += vec[i] | vec2[i];
+            differ += vec[i] ^ vec2[i];
+            and_not += vec[i] & !vec2[i];
+        }
+
+        ASSERT_TRUE_MSG(bits.Count() == ones, "BitVector popcount")
+        ASSERT_TRUE_MSG((bits ^ bits2).Count() == differ && HammingDistance(bits, bits2) == differ, "BitVector XOR")
+        ASSERT_TRUE_MSG(AndNot(bits, bits2).Count() == and_not, "BitVector ANDNOT")
+        ASSERT_TRUE_MSG(fabs(JaccardSimilarity(bits, bits2) - (united ? double(common) / united : 1.)) < EPS,
+                        "BitVector Jaccard")
+        ASSERT_TRUE_MSG(BitVector(bits).Flip().Count() == vec.size() - ones, "BitVector flip")
+
+        auto set_bits = bits.SetBits();
+        ASSERT_TRUE_MSG(set_bits.size() == ones, "BitVector set bits")
+        for (auto i: set_bits) {
+            ASSERT_TRUE_MSG(vec[i] == 1, "BitVector set bits")
+        }
+    }
+
+    REPEAT(100)
+    {
+        std::vector<double> buffer;
+        RandomFillDouble(buffer, 3000);
+        Span<const double> all(buffer);
+        auto a = all.subspan(0, 1000), b = all.subspan(1000, 1000);
+        std::vector<double> vec_a(a.begin(), a.end()), vec_b(b.begin(), b.end());
+
+        std::vector<double> out(1000);
+        Transform<double>(a, b, out, std::plus<double>());
+        auto expected = vec_a + vec_b;
+        ASSERT_EQUAL_MSG(out, expected, "Span transform")
+
+        ASSERT_TRUE_MSG(Dot(a, b) == vec_a * vec_b, "Span dot product")
+        ASSERT_TRUE_MSG(Sum(lazy(a) - lazy(vec_a)) == 0., "Span lazy expression")
+        ASSERT_TRUE_MSG(Collinear(a, a) == 1 && Collinear(a, b) == (vec_a || vec_b), "Span collinearity")
+
+        Span<double> tail(buffer.data() + 2000, buffer.data() + 3000);
+        auto alpha = RandomDouble();
+        expected = std::vector<double>(tail.begin(), tail.end());
+        Axpy(alpha, vec_a, expected);
+        Axpy(alpha, a, tail);
+        ASSERT_EQUAL_MSG(tail, expected, "Span axpy")
+
+        expected = -vec_b;
+        Negate<double>(b, tail);
+        ASSERT_EQUAL_MSG(tail, expected, "Span negate")
+
+        reverse(tail);
+        std::reverse(expected.begin(), expected.end());
+        ASSERT_EQUAL_MSG(tail, expected, "Span reverse")
+
+        std::vector<double> cross(3);
+        Cross<double>(a.subspan(0, 3), b.subspan(0, 3), cross);
+        expected = std::vector<double>(a.begin(), a.begin() + 3) % std::vector<double>(b.begin(), b.begin() + 3);
+        ASSERT_EQUAL_MSG(cross, expected, "Span cross product")
+    }
+
+    REPEAT(10)
+    {
+        std::vector<double> vec, vec2;
+        std::vector<int> ints, ints2;
+        RandomFillDouble(vec, RandomUInt(0, 50'000));
+        RandomFill(ints, RandomUInt(1, 1001), 1000);
+
+        std::stringstream stream;
+        WriteBinary(stream, vec);
+        WriteBinary(stream, ints);
+        ReadBinary(stream, vec2);
+        ReadBinary(stream, ints2);
+        ASSERT_TRUE_MSG(stream && vec2 == vec && ints2 == ints, "Binary round trip")
+
+        ReadBinary(stream, vec2);
+        ASSERT_TRUE_MSG(!stream && vec2 == vec, "Binary end of stream")
+
+        stream.clear();
+        stream.str("");
+        WriteBinary(stream, ints);
+        ReadBinary(stream, vec2);
+        ASSERT_TRUE_MSG(stream.fail() && vec2 == vec, "Binary type mismatch")
+
+        // A header claiming far more data than follows fails without
+        // allocating for the claimed count.
+        for (uint64_t claimed: {uint64_t(1) << 40, ~uint64_t(0)}) {
+            stream.clear();
+            stream.str("");
+            auto header = MakeFrameHeader<double>(claimed);
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(double));
+            ReadBinary(stream, vec2);
+            ASSERT_TRUE_MSG(stream.fail() && vec2 == vec, "Binary oversized count")
+        }
+
+        stream.clear();
+        stream.str("");
+        WriteBinary(stream, vec);
+        auto truncated = stream.str();
+        stream.str(truncated.substr(0, truncated.size() / 2));
+        ReadBinary(stream, vec2);
+        ASSERT_TRUE_MSG(stream.fail() && vec2 == vec, "Binary truncated frame")
+
+        char path[] = "/tmp/vector_io_testXXXXXX";
+        auto fd = mkstemp(path);
+        ASSERT_TRUE(fd >= 0)
+        close(fd);
+        {
+            std::ofstream file(path, std::ios::binary);
+            WriteBinary(file, vec);
+            WriteBinary(file, ints);
+        }
+        {
+            MappedVectorFile mapped(path);
+            ASSERT_TRUE_MSG(mapped.size() == 2, "Mapped frames")
+            auto doubles = mapped.Get<double>(0);
+            auto mapped_ints = mapped.Get<int>(1);
+            ASSERT_EQUAL_MSG(doubles, vec, "Mapped doubles")
+            ASSERT_EQUAL_MSG(mapped_ints, ints, "Mapped ints")
+        }
+        std::remove(path);
+
+        std::string text = std::to_string(vec.size()) + "\n";
+        FormatText(vec, text);
+        vec2.clear();
+        auto end = ParseText(text.data(), text.data() + text.size(), vec2);
+        ASSERT_TRUE_MSG(end != nullptr && vec2 == vec, "Text round trip")
+
+        stream.clear();
+        stream.str("");
+        stream << ints.size() << '\n';
+        WriteText(stream, ints);
+        stream << vec.size() << '\n';
+        WriteText(stream, vec);
+        ints2.clear();
+        vec2.clear();
+        ReadText(stream, ints2);
+        ReadText(stream, vec2);
+        ASSERT_TRUE_MSG(stream && ints2 == ints && vec2 == vec, "Text stream round trip")
+
+        stream.clear();
+        stream.str("3 1 2 x");
+        ReadText(stream, ints2);
+        ASSERT_TRUE_MSG(stream.fail() && ints2 == ints, "Text malformed input")
+
+        // A huge count is rejected once the values run out, without
+        // allocating for it first.
+        for (std::string huge: {"4000000000000 1 2", "18446744073709551615 1 2"}) {
+            ASSERT_TRUE_MSG(ParseText(huge.data(), huge.data() + huge.size(), ints2) == nullptr && ints2 == ints,
+                            "Text oversized count")
+            stream.clear();
+            stream.str(huge);
+            ReadText(stream, ints2);
+            ASSERT_TRUE_MSG(stream.fail() && ints2 == ints, "Text stream oversized count")
+        }
+    }
+
+    REPEAT(5)
+    {
+        std::vector<double> vec, vec2;
+        RandomFillDouble(vec, RandomUInt(100'000, 300'000));
+        RandomFillDouble(vec2, vec.size());
+
+        auto sum = ParallelSum(vec, 1);
+        auto dot = ParallelDot(vec, vec2, 1);
+        for (size_t threads: {2, 3, 8}) {
+            ASSERT_TRUE_MSG(ParallelSum(vec, threads) == sum, "Reproducible sum")
+            ASSERT_TRUE_MSG(ParallelDot(vec, vec2, threads) == dot, "Reproducible dot product")
+        }
+
+        ASSERT_TRUE_MSG(fabs(sum - std::accumulate(vec.begin(), vec.end(), 0.)) < 1e-6, "Parallel sum")
+        ASSERT_TRUE_MSG(fabs(dot - vec * vec2) < 1e-6, "Parallel dot product")
+        ASSERT_TRUE_MSG(fabs(ParallelNorm(vec) - std::sqrt(vec * vec)) < 1e-6, "Parallel norm")
+
+        auto max_it = std::max_element(vec.begin(), vec.end());
+        auto min_it = std::min_element(vec.begin(), vec.end());
+        ASSERT_TRUE_MSG(ParallelMax(vec, 4) == *max_it && ParallelMin(vec, 4) == *min_it, "Parallel min/max")
+        ASSERT_TRUE_MSG(ParallelArgMax(vec, 4) == size_t(max_it - vec.begin()), "Parallel argmax")
+        ASSERT_TRUE_MSG(ParallelArgMin(vec, 4) == size_t(min_it - vec.begin()), "Parallel argmin")
+
+        std::vector<int> ties(50'000, 7);
+        ties[30'000] = ties[40'000] = 9;
+        ASSERT_TRUE_MSG(ParallelArgMax(ties, 4) == 30'000, "Parallel argmax ties")
+        ASSERT_TRUE_MSG(ParallelSum(Span<const int>(ties).subspan(0, 10)) == 70, "Parallel sum over span")
+    }
+
+    REPEAT(3)
+    {
+        const size_t dim = 16, count = 3000, k = 5;
+        std::vector<double> block;
+        RandomFillDouble(block, count * dim);
+
+        IvfIndex<double> index(dim, 20);
+        index.Train(block, 5, 4, RandomUInt(1000));
+        index.AddBatch(Span<const double>(block).subspan(0, count / 2 * dim), 4);
+        for (size_t i = count / 2; i < count; ++i) {
+            ASSERT_TRUE_MSG(index.Add(Span<const double>(block).subspan(i * dim, dim)) == i, "Index ids")
+        }
+        ASSERT_TRUE(index.size() == count)
+
+        std::vector<double> queries;
+        RandomFillDouble(queries, 20 * dim);
+        auto results = index.SearchBatch(queries, k, index.lists(), 3);
+
+        for (size_t q = 0; q < results.size(); ++q) {
+            std::vector<double> query(queries.begin() + q * dim, queries.begin() + (q + 1) * dim);
+            std::vector<std::pair<double, size_t>> exact;
+            for (size_t i = 0; i < count; ++i) {
+                std::vector<double> row(block.begin() + i * dim, block.begin() + (i + 1) * dim);
+                auto diff = row - query;
+                exact.emplace_back(diff * diff, i);
+            }
+            std::sort(exact.begin(), exact.end());
+
+            ASSERT_TRUE(results[q].size() == k)
+            for (size_t i = 0; i < k; ++i) {
+                ASSERT_TRUE_MSG(results[q][i].second == exact[i].second, "Exhaustive index search")
+                ASSERT_TRUE_MSG(fabs(results[q][i].first - exact[i].first) < 1e-6, "Index distance")
+            }
+        }
+
+        for (size_t i = 0; i < count; i += 101) {
+            auto self = index.Search(Span<const double>(block).subspan(i * dim, dim), 1);
+            ASSERT_TRUE_MSG(self.size() == 1 && self[0].second == i, "Index self query")
+        }
+
+        std::stringstream stream;
+        index.Save(stream);
+        IvfIndex<double> loaded;
+        ASSERT_TRUE_MSG(loaded.Load(stream) && loaded.size() == count, "Index load")
+        ASSERT_TRUE_MSG(loaded.SearchBatch(queries, k, 3) == index.SearchBatch(queries, k, 3), "Index save/load")
+
+        stream.str("garbage");
+        ASSERT_TRUE_MSG(!loaded.Load(stream) && loaded.size() == count, "Index malformed input")
+
+        // Truncated data and counts beyond the data fail before anything is
+        // allocated for them.
+        std::stringstream saved;
+        index.Save(saved);
+        auto bytes = saved.str();
+        stream.clear();
+        stream.str(bytes.substr(0, bytes.size() / 2));
+        ASSERT_TRUE_MSG(!loaded.Load(stream) && loaded.size() == count, "Index truncated input")
+
+        // The centroids frame follows the type frame and the 4-value meta frame.
+        auto oversized = bytes;
+        uint64_t claimed = uint64_t(1) << 40;
+        std::memcpy(&oversized[16 + 16 + 32 + 8], &claimed, sizeof(claimed));
+        stream.clear();
+        stream.str(oversized);
+        ASSERT_TRUE_MSG(!loaded.Load(stream) && loaded.size() == count, "Index oversized count")
+
+        // Ids must be unique and below size(), or a later Add would reuse
+        // one. Walk the frames to the first inverted list with two ids.
+        size_t offset = 16 + 16 + 32 + 16 + index.lists() * dim * sizeof(double);
+        uint64_t ids = 0;
+        for (size_t c = 0; c < index.lists(); ++c) {
+            std::memcpy(&ids, &bytes[offset + 8], sizeof(ids));
+            if (ids >= 2)
+                break;
+            offset += 16 + ids * sizeof(uint64_t) + 16 + ids * dim * sizeof(double);
+        }
+        ASSERT_TRUE(ids >= 2)
+
+        auto duplicate = bytes;
+        std::memcpy(&duplicate[offset + 16 + 8], &duplicate[offset + 16], sizeof(uint64_t));
+        stream.clear();
+        stream.str(duplicate);
+        ASSERT_TRUE_MSG(!loaded.Load(stream) && loaded.size() == count, "Index duplicate id")
+
+        auto out_of_range = bytes;
+        uint64_t next_id = count;
+        std::memcpy(&out_of_range[offset + 16], &next_id, sizeof(next_id));
+        stream.clear();
+        stream.str(out_of_range);
+        ASSERT_TRUE_MSG(!loaded.Load(stream) && loaded.size() == count, "Index id out of range")
+
+        stream.clear();
+        stream.str(bytes);
+        ASSERT_TRUE_MSG(loaded.Load(stream) && loaded.size() == count, "Index reload")
+    }
+
 }